@@ -3,6 +3,9 @@
  * @brief Definitions for audio capture and encoding.
  */
 // standard includes
+#include <algorithm>
+#include <map>
+#include <mutex>
 #include <thread>
 
 // lib includes
@@ -13,7 +16,10 @@
 #include "config.h"
 #include "globals.h"
 #include "logging.h"
+#include "mail.h"
+#include "pcm_ring.h"
 #include "platform/common.h"
+#include "rate_control.h"
 #include "thread_safe.h"
 #include "utility.h"
 
@@ -23,10 +29,13 @@ namespace audio {
    * @brief Owning pointer for an Opus multistream encoder.
    */
   using opus_t = util::safe_ptr<OpusMSEncoder, opus_multistream_encoder_destroy>;
-  /**
-   * @brief Shared queue carrying captured PCM sample buffers to the encoder thread.
-   */
-  using sample_queue_t = std::shared_ptr<safe::queue_t<std::vector<float>>>;
+
+  constexpr std::size_t MAX_PACKET_SIZE = 1400;  ///< Largest Opus packet the encoder may produce.
+  constexpr std::size_t MAX_POOLED_BUFFERS = 64;  ///< Free packet buffers kept for reuse by a pipeline.
+  constexpr std::size_t MAX_QUEUED_FRAMES = 30;  ///< Captured frames that may wait for the encoder.
+
+  // Must match RTPA_DATA_SHARDS, the parity of an audio FEC block is computed over packets of equal size
+  constexpr std::uint64_t FEC_BLOCK_PACKETS = 4;  ///< Audio packets protected by one FEC block.
 
   static int start_audio_control(audio_ctx_t &ctx);
   static void stop_audio_control(audio_ctx_t &);
@@ -99,102 +108,348 @@ namespace audio {
     },
   };
 
+  /**
+   * @brief Audio settings that must match for sessions to share a capture and encoder.
+   */
+  struct pipeline_key_t {
+    int channelCount;  ///< Number of audio channels in the Opus layout.
+    int streams;  ///< Number of Opus streams in the layout.
+    int coupledStreams;  ///< Number of stereo-coupled Opus streams.
+    std::array<std::uint8_t, 8> mapping;  ///< Channel mapping table of the layout.
+    int bitrate;  ///< Target bitrate in bits per second.
+    int packetDuration;  ///< Packet duration in milliseconds.
+    bool host_audio;  ///< Whether audio keeps playing on the host.
+    bool continuous_audio;  ///< Whether packets are sent during silence.
+
+    auto operator<=>(const pipeline_key_t &) const = default;
+  };
+
+  /**
+   * @brief Session the encoded packets of a pipeline are queued for.
+   */
+  struct subscriber_t {
+    void *channel_data;  ///< Session the packets are queued for.
+    safe::mail_raw_t::event_t<rate_control::audio_settings_t> settings_events;  ///< Encoder settings requested by the session.
+    rate_control::audio_settings_t settings;  ///< Last encoder settings requested by the session.
+    std::uint64_t first_packet;  ///< Index of the first encoded packet queued for the session.
+  };
+
+  /**
+   * @brief Capture and Opus encoder shared by every session with the same audio settings.
+   *
+   * Samples are captured and encoded once, and each encoded packet is queued once for every
+   * subscribed session. Sessions still encrypt and number the packets on their own when
+   * sending them. The pipeline stops when the last session lets go of it.
+   */
+  struct pipeline_t {
+    ~pipeline_t() {
+      shutdown.raise(true);
+
+      // Starting the pipeline may have failed before the capture device was open
+      if (samples) {
+        samples->stop();
+      }
+    }
+
+    /**
+     * @brief Start sending encoded packets to a session.
+     *
+     * The session gets its first packet at the start of the next FEC block of the pipeline,
+     * so the encoder settings only ever change between the FEC blocks of every session.
+     *
+     * @param channel_data Session the packets are queued for.
+     * @param settings_events Encoder settings requested by the session.
+     */
+    void subscribe(void *channel_data, safe::mail_raw_t::event_t<rate_control::audio_settings_t> settings_events) {
+      std::lock_guard lg {subscribers_lock};
+
+      auto first_packet = (encoded_packets + FEC_BLOCK_PACKETS - 1) / FEC_BLOCK_PACKETS * FEC_BLOCK_PACKETS;
+      subscribers.emplace_back(subscriber_t {channel_data, std::move(settings_events), {}, first_packet});
+    }
+
+    /**
+     * @brief Stop sending encoded packets to a session.
+     *
+     * @param channel_data Session passed to subscribe().
+     */
+    void unsubscribe(void *channel_data) {
+      std::lock_guard lg {subscribers_lock};
+      std::erase_if(subscribers, [&](const subscriber_t &subscriber) {
+        return subscriber.channel_data == channel_data;
+      });
+    }
+
+    /**
+     * @brief Combine the encoder settings requested by the sessions.
+     *
+     * Sessions share the encoder, so it follows the one with the worst connection.
+     * Must be called with subscribers_lock held.
+     *
+     * @param current Settings to keep if no session is subscribed.
+     * @return The encoder settings to use.
+     */
+    rate_control::audio_settings_t requested_settings(const rate_control::audio_settings_t &current) {
+      if (subscribers.empty()) {
+        return current;
+      }
+
+      rate_control::audio_settings_t settings;
+      for (auto &subscriber : subscribers) {
+        if (auto requested = subscriber.settings_events->try_pop()) {
+          subscriber.settings = *requested;
+        }
+
+        settings.bitrate_percentage = std::min(settings.bitrate_percentage, subscriber.settings.bitrate_percentage);
+        settings.loss_percentage = std::max(settings.loss_percentage, subscriber.settings.loss_percentage);
+        settings.inband_fec = settings.inband_fec || subscriber.settings.inband_fec;
+      }
+
+      return settings;
+    }
+
+    config_t config;  ///< Audio settings of the first session, shared by all subscribers.
+    opus_stream_config_t stream;  ///< Opus layout and bitrate of the encoder.
+    audio_ctx_ref_t ref;  ///< Audio context kept alive while capturing.
+    std::unique_ptr<platf::mic_t> mic;  ///< Capture device.
+
+    safe::event_t<bool> shutdown;  ///< Raised when the pipeline stops, or when capture failed.
+    std::unique_ptr<pcm_ring::ring_t> samples;  ///< Captured PCM frames waiting to be encoded, null until the capture device is open.
+
+    // Packets circulate from encoding to the sessions sending them, and then come back
+    // here instead of being freed
+    std::shared_ptr<safe::pool_t<buffer_t>> packet_pool;  ///< Recycled encoded packet buffers.
+
+    std::mutex subscribers_lock;  ///< Protects subscribers and encoded_packets.
+    std::vector<subscriber_t> subscribers;  ///< Sessions the encoded packets are queued for.
+    std::uint64_t encoded_packets = 0;  ///< Packets encoded since the pipeline started.
+
+    std::jthread capture_thread;  ///< Thread that captures samples.
+    std::jthread encode_thread;  ///< Thread that encodes samples and fans the packets out.
+  };
+
   /**
    * @brief Encode captured PCM samples into Opus packets on the audio worker thread.
    *
-   * @param samples Queue of captured PCM sample buffers to encode.
-   * @param config Audio stream settings negotiated with the client.
-   * @param channel_data Platform-specific audio capture context passed to packet metadata.
+   * @param pipeline Pipeline whose samples are encoded and whose subscribers get the packets.
    */
-  void encodeThread(sample_queue_t samples, config_t config, void *channel_data) {
+  void encodeThread(pipeline_t &pipeline) {
     auto packets = mail::man->queue<packet_t>(mail::audio_packets);
-    auto stream = stream_configs[map_stream(config.channels, config.flags[config_t::HIGH_QUALITY])];
-    if (config.flags[config_t::CUSTOM_SURROUND_PARAMS]) {
-      apply_surround_params(stream, config.customStreamParams);
-    }
+    auto &stream = pipeline.stream;
 
     // Encoding takes place on this thread
     platf::set_thread_name("audio::encode");
     platf::adjust_thread_priority(platf::thread_priority_e::high);
 
-    opus_t opus {opus_multistream_encoder_create(
-      stream.sampleRate,
-      stream.channelCount,
-      stream.streams,
-      stream.coupledStreams,
-      stream.mapping,
-      OPUS_APPLICATION_RESTRICTED_LOWDELAY,
-      nullptr
-    )};
-
-    opus_multistream_encoder_ctl(opus.get(), OPUS_SET_BITRATE(stream.bitrate));
-    opus_multistream_encoder_ctl(opus.get(), OPUS_SET_VBR(0));
+    // In-band FEC is only produced by the SILK layer, which needs packets of at least 10 ms
+    // and isn't available in the restricted low delay mode
+    bool inband_fec = config::stream.audio_adaptive && pipeline.config.packetDuration >= 10;
+
+    // The restricted low delay mode can't be left once the encoder runs, so the encoder is
+    // created again to switch modes
+    auto make_opus = [&](int application) {
+      opus_t opus {opus_multistream_encoder_create(
+        stream.sampleRate,
+        stream.channelCount,
+        stream.streams,
+        stream.coupledStreams,
+        stream.mapping,
+        application,
+        nullptr
+      )};
+
+      opus_multistream_encoder_ctl(opus.get(), OPUS_SET_BITRATE(stream.bitrate));
+      opus_multistream_encoder_ctl(opus.get(), OPUS_SET_VBR(0));
+
+      return opus;
+    };
+
+    // The lookahead of the AUDIO mode is only paid while the client reports loss
+    auto application = OPUS_APPLICATION_RESTRICTED_LOWDELAY;
+    auto opus = make_opus(application);
 
     BOOST_LOG(info) << "Opus initialized: "sv << stream.sampleRate / 1000 << " kHz, "sv
                     << stream.channelCount << " channels, "sv
                     << stream.bitrate / 1000 << " kbps (total), LOWDELAY"sv;
 
-    auto frame_size = config.packetDuration * stream.sampleRate / 1000;
-    while (auto sample = samples->pop()) {
-      buffer_t packet {1400};
+    rate_control::audio_settings_t settings;
+
+    auto frame_size = pipeline.config.packetDuration * stream.sampleRate / 1000;
+    std::vector<float> sample;
+    std::chrono::steady_clock::time_point capture_timestamp;
+    while (pipeline.samples->pop(sample, capture_timestamp)) {
+      // Parity is computed over packets of the same size, so with a constant bitrate the
+      // settings may only change at the start of an FEC block
+      if (config::stream.audio_adaptive) {
+        std::unique_lock ul {pipeline.subscribers_lock};
+        if (pipeline.encoded_packets % FEC_BLOCK_PACKETS == 0) {
+          auto requested = pipeline.requested_settings(settings);
+          ul.unlock();
+
+          if (requested != settings) {
+            settings = requested;
+
+            auto requested_application = inband_fec && settings.inband_fec ? OPUS_APPLICATION_AUDIO : OPUS_APPLICATION_RESTRICTED_LOWDELAY;
+            if (requested_application != application) {
+              application = requested_application;
+              opus = make_opus(application);
+
+              BOOST_LOG(info) << "Opus switched to "sv << (application == OPUS_APPLICATION_AUDIO ? "AUDIO"sv : "LOWDELAY"sv) << " mode"sv;
+            }
+
+            auto bitrate = (opus_int32) ((std::int64_t) stream.bitrate * settings.bitrate_percentage / 100);
+            opus_multistream_encoder_ctl(opus.get(), OPUS_SET_BITRATE(bitrate));
+            opus_multistream_encoder_ctl(opus.get(), OPUS_SET_PACKET_LOSS_PERC(settings.loss_percentage));
+            opus_multistream_encoder_ctl(opus.get(), OPUS_SET_INBAND_FEC(inband_fec && settings.inband_fec ? 1 : 0));
 
-      int bytes = opus_multistream_encode_float(opus.get(), sample->data(), frame_size, std::begin(packet), (opus_int32) packet.size());
+            BOOST_LOG(info) << "Opus reconfigured: "sv << bitrate / 1000 << " kbps (total), "sv
+                            << settings.loss_percentage << "% expected loss, in-band FEC "sv
+                            << (inband_fec && settings.inband_fec ? "on"sv : "off"sv);
+          }
+        }
+      }
+
+      // Pooled packets were shrunk to the size of their last payload
+      auto packet = pipeline.packet_pool->acquire();
+      packet->fake_resize(MAX_PACKET_SIZE);
+
+      int bytes = opus_multistream_encode_float(opus.get(), sample.data(), frame_size, std::begin(*packet), (opus_int32) packet->size());
       if (bytes < 0) {
         BOOST_LOG(error) << "Couldn't encode audio: "sv << opus_strerror(bytes);
         packets->stop();
 
-        return;
+        break;
       }
 
-      packet.fake_resize(bytes);
-      packets->raise(channel_data, std::move(packet));
+      packet->fake_resize(bytes);
+
+      std::lock_guard lg {pipeline.subscribers_lock};
+      auto index = pipeline.encoded_packets++;
+
+      // Sessions that joined mid-block wait for the next block, so each of their FEC blocks
+      // lines up with one of the pipeline
+      void *last = nullptr;
+      for (auto &subscriber : pipeline.subscribers) {
+        if (index < subscriber.first_packet) {
+          continue;
+        }
+
+        // Each session sends its own copy, the last one takes the original
+        if (last) {
+          auto copy = pipeline.packet_pool->acquire();
+          copy->fake_resize(bytes);
+          std::copy_n(std::begin(*packet), bytes, std::begin(*copy));
+          packets->raise(last, std::move(copy), capture_timestamp);
+        }
+        last = subscriber.channel_data;
+      }
+      if (last) {
+        packets->raise(last, std::move(packet), capture_timestamp);
+      }
     }
+
+    auto ring_stats = pipeline.samples->stats();
+    BOOST_LOG(debug) << "Audio capture: "sv << ring_stats.pushed << " frames, "sv
+                     << ring_stats.overruns << " dropped before encoding, "sv
+                     << ring_stats.underruns << " frames captured late"sv;
   }
 
   /**
-   * @brief Run the capture loop for this backend.
+   * @brief Capture samples for a pipeline until it stops.
+   *
+   * @param pipeline Pipeline whose microphone is read.
    */
-  void capture(safe::mail_t mail, config_t config, void *channel_data) {
-    auto shutdown_event = mail->event<bool>(mail::shutdown);
-    if (!config::audio.stream) {
-      shutdown_event->view();
-      return;
+  void captureThread(pipeline_t &pipeline) {
+    auto &stream = pipeline.stream;
+    auto &control = pipeline.ref->control;
+
+    // Capture takes place on this thread
+    platf::set_thread_name("audio::capture");
+    platf::adjust_thread_priority(platf::thread_priority_e::critical);
+
+    auto frame_size = pipeline.config.packetDuration * stream.sampleRate / 1000;
+    bool host_audio = pipeline.config.flags[config_t::HOST_AUDIO];
+    bool continuous_audio = pipeline.config.flags[config_t::CONTINUOUS_AUDIO];
+
+    // Sessions that are still subscribed keep waiting for their own shutdown, but new ones
+    // won't join a pipeline that can no longer capture
+    auto fg = util::fail_guard([&]() {
+      pipeline.shutdown.raise(true);
+    });
+
+    logging::min_max_avg_periodic_logger<double> capture_latency_logger(debug, "Audio: capture latency", "ms");
+
+    // Frames are copied into the ring, so a single buffer is reused for every capture
+    std::vector<float> sample_buffer(pipeline.samples->frame_samples());
+    while (!pipeline.shutdown.peek()) {
+      auto status = pipeline.mic->sample(sample_buffer);
+      switch (status) {
+        case platf::capture_e::ok:
+          break;
+        case platf::capture_e::timeout:
+          continue;
+        case platf::capture_e::reinit:
+          BOOST_LOG(info) << "Reinitializing audio capture"sv;
+          pipeline.mic.reset();
+          do {
+            pipeline.mic = control->microphone(stream.mapping, stream.channelCount, stream.sampleRate, frame_size, continuous_audio, host_audio);
+            if (!pipeline.mic) {
+              BOOST_LOG(warning) << "Couldn't re-initialize audio input"sv;
+            }
+          } while (!pipeline.mic && !pipeline.shutdown.view(5s));
+          continue;
+        default:
+          return;
+      }
+
+      // The last sample of the frame was captured as long ago as the server kept it
+      auto capture_timestamp = std::chrono::steady_clock::now();
+      if (auto latency = pipeline.mic->capture_latency()) {
+        capture_latency_logger.collect_and_log(std::chrono::duration<double, std::milli>(*latency).count());
+        capture_timestamp -= *latency;
+      }
+
+      pipeline.samples->push(sample_buffer.data(), capture_timestamp);
     }
-    auto stream = stream_configs[map_stream(config.channels, config.flags[config_t::HIGH_QUALITY])];
+  }
+
+  /**
+   * @brief Open the audio device and start capturing and encoding for a new pipeline.
+   *
+   * @param config Audio stream settings negotiated with the client.
+   * @param stream Opus layout and bitrate for the settings.
+   * @return The running pipeline, or nullptr if audio capture couldn't be initialized.
+   */
+  std::shared_ptr<pipeline_t> open_pipeline(const config_t &config, const opus_stream_config_t &stream) {
+    auto pipeline = std::make_shared<pipeline_t>();
+    pipeline->config = config;
+    pipeline->stream = stream;
     if (config.flags[config_t::CUSTOM_SURROUND_PARAMS]) {
-      apply_surround_params(stream, config.customStreamParams);
+      // The mapping must outlive the config of the session that opened the pipeline
+      pipeline->stream.mapping = pipeline->config.customStreamParams.mapping;
     }
 
-    auto ref = get_audio_ctx_ref();
-    if (!ref) {
-      return;
+    pipeline->ref = get_audio_ctx_ref();
+    if (!pipeline->ref) {
+      return nullptr;
     }
 
-    auto init_failure_fg = util::fail_guard([&shutdown_event]() {
-      BOOST_LOG(error) << "Unable to initialize audio capture. The stream will not have audio."sv;
-
-      // Wait for shutdown to be signalled if we fail init.
-      // This allows streaming to continue without audio.
-      shutdown_event->view();
-    });
-
-    auto &control = ref->control;
+    auto &control = pipeline->ref->control;
     if (!control) {
-      return;
+      return nullptr;
     }
 
     // Order of priority:
     // 1. Virtual sink
     // 2. Audio sink
     // 3. Host
-    std::string *sink = &ref->sink.host;
+    std::string *sink = &pipeline->ref->sink.host;
     if (!config::audio.sink.empty()) {
       sink = &config::audio.sink;
     }
 
     // Prefer the virtual sink if host playback is disabled or there's no other sink
-    if (ref->sink.null && (!config.flags[config_t::HOST_AUDIO] || sink->empty())) {
-      auto &null = *ref->sink.null;
+    if (pipeline->ref->sink.null && (!config.flags[config_t::HOST_AUDIO] || sink->empty())) {
+      auto &null = *pipeline->ref->sink.null;
       switch (stream.channelCount) {
         case 2:
           sink = &null.stereo;
@@ -209,12 +464,12 @@ namespace audio {
     }
 
     // Only the first to start a session may change the default sink
-    if (!ref->sink_flag->exchange(true, std::memory_order_acquire)) {
+    if (!pipeline->ref->sink_flag->exchange(true, std::memory_order_acquire)) {
       // If the selected sink is different than the current one, change sinks.
-      ref->restore_sink = ref->sink.host != *sink;
-      if (ref->restore_sink) {
+      pipeline->ref->restore_sink = pipeline->ref->sink.host != *sink;
+      if (pipeline->ref->restore_sink) {
         if (control->set_sink(*sink)) {
-          return;
+          return nullptr;
         }
       }
     }
@@ -222,55 +477,100 @@ namespace audio {
     auto frame_size = config.packetDuration * stream.sampleRate / 1000;
     bool host_audio = config.flags[config_t::HOST_AUDIO];
     bool continuous_audio = config.flags[config_t::CONTINUOUS_AUDIO];
-    auto mic = control->microphone(stream.mapping, stream.channelCount, stream.sampleRate, frame_size, continuous_audio, host_audio);
-    if (!mic) {
-      return;
+    pipeline->mic = control->microphone(pipeline->stream.mapping, stream.channelCount, stream.sampleRate, frame_size, continuous_audio, host_audio);
+    if (!pipeline->mic) {
+      return nullptr;
     }
 
-    // Audio is initialized, so we don't want to print the failure message
-    init_failure_fg.disable();
+    pipeline->samples = std::make_unique<pcm_ring::ring_t>(MAX_QUEUED_FRAMES, frame_size * stream.channelCount, std::chrono::milliseconds {config.packetDuration});
+    pipeline->packet_pool = safe::pool_t<buffer_t>::make([]() {
+      return buffer_t {MAX_PACKET_SIZE};
+    }, MAX_POOLED_BUFFERS);
 
-    // Capture takes place on this thread
-    platf::adjust_thread_priority(platf::thread_priority_e::critical);
+    pipeline->encode_thread = std::jthread {encodeThread, std::ref(*pipeline)};
+    pipeline->capture_thread = std::jthread {captureThread, std::ref(*pipeline)};
 
-    auto samples = std::make_shared<sample_queue_t::element_type>(30);
-    std::jthread thread {encodeThread, samples, config, channel_data};
+    return pipeline;
+  }
 
-    auto fg = util::fail_guard([&]() {
-      samples->stop();
-      thread.join();
+  /**
+   * @brief Get the running pipeline for a set of audio settings, starting one if needed.
+   *
+   * @param config Audio stream settings negotiated with the client.
+   * @return The shared pipeline, or nullptr if audio capture couldn't be initialized.
+   */
+  std::shared_ptr<pipeline_t> acquire_pipeline(const config_t &config) {
+    static std::mutex pipelines_lock;
+    static std::map<pipeline_key_t, std::weak_ptr<pipeline_t>> pipelines;
 
-      shutdown_event->view();
+    auto stream = stream_configs[map_stream(config.channels, config.flags[config_t::HIGH_QUALITY])];
+    if (config.flags[config_t::CUSTOM_SURROUND_PARAMS]) {
+      apply_surround_params(stream, config.customStreamParams);
+    }
+
+    pipeline_key_t key {
+      stream.channelCount,
+      stream.streams,
+      stream.coupledStreams,
+      {},
+      stream.bitrate,
+      config.packetDuration,
+      config.flags[config_t::HOST_AUDIO],
+      config.flags[config_t::CONTINUOUS_AUDIO],
+    };
+    std::copy_n(stream.mapping, std::min<std::size_t>(stream.channelCount, key.mapping.size()), std::begin(key.mapping));
+
+    // Held while a new pipeline opens, so sessions starting together don't open the device twice
+    std::lock_guard lg {pipelines_lock};
+
+    std::erase_if(pipelines, [](const auto &entry) {
+      return entry.second.expired();
     });
 
-    int samples_per_frame = frame_size * stream.channelCount;
+    if (auto it = pipelines.find(key); it != std::end(pipelines)) {
+      auto pipeline = it->second.lock();
+      if (pipeline && !pipeline->shutdown.peek()) {
+        BOOST_LOG(info) << "Sharing audio capture and encoder with another session"sv;
+        return pipeline;
+      }
+    }
 
-    while (!shutdown_event->peek()) {
-      std::vector<float> sample_buffer;
-      sample_buffer.resize(samples_per_frame);
+    auto pipeline = open_pipeline(config, stream);
+    if (pipeline) {
+      pipelines[key] = pipeline;
+    }
 
-      auto status = mic->sample(sample_buffer);
-      switch (status) {
-        case platf::capture_e::ok:
-          break;
-        case platf::capture_e::timeout:
-          continue;
-        case platf::capture_e::reinit:
-          BOOST_LOG(info) << "Reinitializing audio capture"sv;
-          mic.reset();
-          do {
-            mic = control->microphone(stream.mapping, stream.channelCount, stream.sampleRate, frame_size, continuous_audio, host_audio);
-            if (!mic) {
-              BOOST_LOG(warning) << "Couldn't re-initialize audio input"sv;
-            }
-          } while (!mic && !shutdown_event->view(5s));
-          continue;
-        default:
-          return;
-      }
+    return pipeline;
+  }
 
-      samples->raise(std::move(sample_buffer));
+  /**
+   * @brief Run the capture loop for this backend.
+   */
+  void capture(safe::mail_t mail, config_t config, void *channel_data) {
+    auto shutdown_event = mail->event<bool>(mail::shutdown);
+    if (!config::audio.stream) {
+      shutdown_event->view();
+      return;
     }
+
+    auto pipeline = acquire_pipeline(config);
+    if (!pipeline) {
+      BOOST_LOG(error) << "Unable to initialize audio capture. The stream will not have audio."sv;
+
+      // Wait for shutdown to be signalled if we fail init.
+      // This allows streaming to continue without audio.
+      shutdown_event->view();
+      return;
+    }
+
+    // Packets for this session are queued until it shuts down. The last session to leave
+    // stops the pipeline when it lets go of it.
+    pipeline->subscribe(channel_data, mail->event<rate_control::audio_settings_t>(mail::audio_settings));
+    auto fg = util::fail_guard([&]() {
+      pipeline->unsubscribe(channel_data);
+    });
+
+    shutdown_event->view();
   }
 
   audio_ctx_ref_t get_audio_ctx_ref() {
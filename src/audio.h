@@ -91,9 +91,11 @@ namespace audio {
    */
   using buffer_t = util::buffer_t<std::uint8_t>;
   /**
-   * @brief Encoded audio packet paired with platform channel metadata.
+   * @brief Encoded audio packet with platform channel metadata and the capture time of its samples.
+   *
+   * The payload is borrowed from the encoder's pool and given back once the packet is sent.
    */
-  using packet_t = std::pair<void *, buffer_t>;
+  using packet_t = std::tuple<void *, safe::pooled_t<buffer_t>, std::chrono::steady_clock::time_point>;
   /**
    * @brief Shared mailbox reference to the global audio context.
    */
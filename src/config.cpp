@@ -802,6 +802,8 @@ namespace config {
     {},  // virtual_sink
     true,  // stream audio
     true,  // install_steam_drivers
+    0,  // audio_fragment
+    0,  // audio_max_buffer
   };
 
   /**
@@ -813,6 +815,19 @@ namespace config {
     APPS_JSON_PATH,
 
     20,  // fecPercentage
+    false,  // fec_adaptive
+    5,  // fec_min_percentage
+    50,  // fec_max_percentage
+    1,  // fec_threads
+    1,  // video_senders
+    false,  // video_pacing
+    200,  // video_pacing_headroom
+    16,  // video_pacing_burst
+    80,  // video_pacing_spread
+    false,  // video_txtime
+    false,  // video_adaptive_bitrate
+    25,  // video_min_bitrate_percentage
+    false,  // audio_adaptive
 
     ENCRYPTION_MODE_NEVER,  // lan_encryption_mode
     ENCRYPTION_MODE_OPPORTUNISTIC,  // wan_encryption_mode
@@ -1705,6 +1720,8 @@ namespace config {
     string_f(vars, "virtual_sink", audio.virtual_sink);
     bool_f(vars, "stream_audio", audio.stream);
     bool_f(vars, "install_steam_audio_drivers", audio.install_steam_drivers);
+    int_between_f(vars, "audio_fragment", audio.fragment, {0, 100});
+    int_between_f(vars, "audio_max_buffer", audio.max_buffer, {0, 2000});
 
     string_restricted_f(vars, "origin_web_ui_allowed", nvhttp.origin_web_ui_allowed, {"pc"sv, "lan"sv, "wan"sv});
 
@@ -1757,6 +1774,23 @@ namespace config {
 #endif
 
     int_between_f(vars, "fec_percentage", stream.fec_percentage, {1, 255});
+    bool_f(vars, "fec_adaptive", stream.fec_adaptive);
+    int_between_f(vars, "fec_min_percentage", stream.fec_min_percentage, {1, 255});
+    int_between_f(vars, "fec_max_percentage", stream.fec_max_percentage, {1, 255});
+    if (stream.fec_max_percentage < stream.fec_min_percentage) {
+      BOOST_LOG(warning) << "config: fec_max_percentage is below fec_min_percentage, using "sv << stream.fec_min_percentage << " for both"sv;
+      stream.fec_max_percentage = stream.fec_min_percentage;
+    }
+    int_between_f(vars, "fec_threads", stream.fec_threads, {1, 4});
+    int_between_f(vars, "video_senders", stream.video_senders, {0, 16});
+    bool_f(vars, "video_pacing", stream.video_pacing);
+    int_between_f(vars, "video_pacing_headroom", stream.video_pacing_headroom, {100, 1000});
+    int_between_f(vars, "video_pacing_burst", stream.video_pacing_burst, {1, 64});
+    int_between_f(vars, "video_pacing_spread", stream.video_pacing_spread, {0, 100});
+    bool_f(vars, "video_txtime", stream.video_txtime);
+    bool_f(vars, "video_adaptive_bitrate", stream.video_adaptive_bitrate);
+    int_between_f(vars, "video_min_bitrate_percentage", stream.video_min_bitrate_percentage, {10, 100});
+    bool_f(vars, "audio_adaptive", stream.audio_adaptive);
 
     map_int_int_f(vars, "keybindings"s, input.keybindings);
 
@@ -214,6 +214,8 @@ namespace config {
     std::string virtual_sink;  ///< Virtual audio sink for audio routing
     bool stream;  ///< Enable audio streaming to clients
     bool install_steam_drivers;  ///< Install Steam audio drivers for enhanced compatibility
+    int fragment;  ///< Target capture fragment in milliseconds, 0 for one audio packet
+    int max_buffer;  ///< Largest capture buffer kept by the audio server in milliseconds, 0 for its default
   };
 
   /**
@@ -239,6 +241,30 @@ namespace config {
 
     int fec_percentage;  ///< Percentage of forward-error-correction packets to add to the stream.
 
+    // Adapt the FEC percentage of each session to the loss reported by its client
+    bool fec_adaptive;  ///< Raise FEC on reported loss and lower it again after a quiet period.
+    int fec_min_percentage;  ///< Lowest FEC percentage used by adaptive FEC.
+    int fec_max_percentage;  ///< Highest FEC percentage used by adaptive FEC.
+
+    int fec_threads;  ///< Number of threads used to encode and encrypt the FEC blocks of a video frame.
+
+    // 0 = one sender thread per session, 1 = one thread for all sessions, N = N shared sender threads
+    int video_senders;  ///< Number of threads that send video packets.
+
+    // Video pacing: rate = max(bitrate * headroom, frame size / (spread * frame interval))
+    bool video_pacing;  ///< Pace video per session from its bitrate, instead of at a fixed rate.
+    int video_pacing_headroom;  ///< Minimum pacing rate as a percentage of the video bitrate.
+    int video_pacing_burst;  ///< Maximum number of video packets sent back-to-back.
+    int video_pacing_spread;  ///< Percentage of the frame interval each frame is spread over.
+    bool video_txtime;  ///< Let the kernel pace video packets with SO_TXTIME where supported.
+
+    // Lower the encoder bitrate on loss or a saturated send path, and raise it again once the link recovers
+    bool video_adaptive_bitrate;  ///< Adapt the video bitrate of each session to network feedback.
+    int video_min_bitrate_percentage;  ///< Lowest adaptive bitrate as a percentage of the negotiated bitrate.
+
+    // Enable Opus in-band FEC on loss and lower the audio bitrate while it persists
+    bool audio_adaptive;  ///< Adapt the audio encoder of each session to the loss reported by its client.
+
     // Video encryption settings for LAN and WAN streams
     int lan_encryption_mode;  ///< Video encryption policy for LAN clients.
     int wan_encryption_mode;  ///< Video encryption policy for WAN clients.
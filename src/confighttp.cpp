@@ -44,6 +44,7 @@
 #include "globals.h"
 #include "httpcommon.h"
 #include "logging.h"
+#include "mail.h"
 #include "network.h"
 #include "nvhttp.h"
 #include "platform/common.h"
@@ -191,6 +191,10 @@ namespace crypto {
      * The resulting ciphertext and the GCM tag are written into the tagged_cipher buffer.
      */
     int gcm_t::encrypt(const std::string_view &plaintext, std::uint8_t *tag, std::uint8_t *ciphertext, aes_t *iv) {
+      return encrypt(std::span {&plaintext, 1}, tag, ciphertext, iv);
+    }
+
+    int gcm_t::encrypt(std::span<const std::string_view> plaintext, std::uint8_t *tag, std::uint8_t *ciphertext, aes_t *iv) {
       if (!encrypt_ctx && init_encrypt_gcm(encrypt_ctx, &key, iv, padding)) {
         return -1;
       }
@@ -202,11 +206,16 @@ namespace crypto {
       }
 
       int final_outlen;
-      int update_outlen;
+      int update_outlen = 0;
 
-      // Encrypt into the caller's buffer
-      if (EVP_EncryptUpdate(encrypt_ctx.get(), ciphertext, &update_outlen, (const std::uint8_t *) plaintext.data(), (int) plaintext.size()) != 1) {
-        return -1;
+      // Encrypt each buffer into the caller's buffer, continuing the same GCM message
+      for (const auto &part : plaintext) {
+        int part_outlen;
+        if (EVP_EncryptUpdate(encrypt_ctx.get(), ciphertext + update_outlen, &part_outlen, (const std::uint8_t *) part.data(), (int) part.size()) != 1) {
+          return -1;
+        }
+
+        update_outlen += part_outlen;
       }
 
       // GCM encryption won't ever fill ciphertext here but we have to call it anyway
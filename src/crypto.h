@@ -6,6 +6,7 @@
 
 // standard includes
 #include <array>
+#include <span>
 
 // lib includes
 #include <openssl/evp.h>
@@ -303,6 +304,16 @@ namespace crypto {
        */
       int encrypt(const std::string_view &plaintext, std::uint8_t *tag, std::uint8_t *ciphertext, aes_t *iv);
 
+      /**
+       * @brief Encrypts several plaintext buffers as one contiguous message using AES GCM mode.
+       * @param plaintext The plaintext buffers to be encrypted, in order.
+       * @param tag The buffer where the GCM tag will be written.
+       * @param ciphertext The buffer where the resulting ciphertext will be written.
+       * @param iv The initialization vector to be used for the encryption.
+       * @return The total length of the ciphertext. Returns -1 in case of an error.
+       */
+      int encrypt(std::span<const std::string_view> plaintext, std::uint8_t *tag, std::uint8_t *ciphertext, aes_t *iv);
+
       /**
        * @brief Encrypts the plaintext using AES GCM mode.
        * length of cipher must be at least: round_to_pkcs7_padded(plaintext.size()) + crypto::cipher::tag_size
@@ -0,0 +1,319 @@
+/**
+ * @file src/gf256.cpp
+ * @brief Definitions for GF(256) Reed-Solomon parity kernels.
+ */
+// standard includes
+#include <array>
+
+// platform includes
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define GF256_X86 1
+  #include <immintrin.h>
+#elif defined(__aarch64__) || (defined(__ARM_NEON) && defined(__arm__))
+  #define GF256_NEON 1
+  #include <arm_neon.h>
+#endif
+
+// local includes
+#include "gf256.h"
+
+namespace gf256 {
+  namespace {
+    /**
+     * @brief Lookup tables shared by every kernel.
+     */
+    struct tables_t {
+      // mul[a][b] = a * b
+      std::array<std::array<std::uint8_t, 256>, 256> mul;
+
+      // split[c][0..15] = c * x, split[c][16..31] = c * (x << 4)
+      std::array<std::array<std::uint8_t, 32>, 256> split;
+    };
+
+    const tables_t &tables() {
+      static const auto t = []() {
+        tables_t t {};
+
+        std::array<std::uint8_t, 512> exp {};
+        std::array<std::uint8_t, 256> log {};
+
+        unsigned x = 1;
+        for (int i = 0; i < 255; ++i) {
+          exp[i] = (std::uint8_t) x;
+          log[x] = (std::uint8_t) i;
+
+          x <<= 1;
+          if (x & 0x100) {
+            x ^= 0x11D;
+          }
+        }
+        for (int i = 255; i < 512; ++i) {
+          exp[i] = exp[i - 255];
+        }
+
+        for (int a = 1; a < 256; ++a) {
+          for (int b = 1; b < 256; ++b) {
+            t.mul[a][b] = exp[log[a] + log[b]];
+          }
+        }
+
+        for (int c = 0; c < 256; ++c) {
+          for (int n = 0; n < 16; ++n) {
+            t.split[c][n] = t.mul[c][n];
+            t.split[c][n + 16] = t.mul[c][n << 4];
+          }
+        }
+
+        return t;
+      }();
+
+      return t;
+    }
+
+    /**
+     * @brief Signature of a multiply (or multiply-accumulate) row kernel.
+     */
+    using row_f = void (*)(std::uint8_t *dst, const std::uint8_t *src, std::uint8_t c, std::size_t len);
+
+    template<bool accumulate>
+    void row_scalar(std::uint8_t *dst, const std::uint8_t *src, std::uint8_t c, std::size_t len) {
+      const auto &row = tables().mul[c];
+
+      for (std::size_t x = 0; x < len; ++x) {
+        if constexpr (accumulate) {
+          dst[x] ^= row[src[x]];
+        } else {
+          dst[x] = row[src[x]];
+        }
+      }
+    }
+
+#ifdef GF256_X86
+    template<bool accumulate>
+    __attribute__((target("ssse3"))) void row_ssse3(std::uint8_t *dst, const std::uint8_t *src, std::uint8_t c, std::size_t len) {
+      const auto *split = tables().split[c].data();
+
+      const auto lo = _mm_loadu_si128((const __m128i *) split);
+      const auto hi = _mm_loadu_si128((const __m128i *) (split + 16));
+      const auto mask = _mm_set1_epi8(0x0F);
+
+      std::size_t x = 0;
+      for (; x + 16 <= len; x += 16) {
+        auto s = _mm_loadu_si128((const __m128i *) (src + x));
+        auto p = _mm_xor_si128(
+          _mm_shuffle_epi8(lo, _mm_and_si128(s, mask)),
+          _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi64(s, 4), mask))
+        );
+        if constexpr (accumulate) {
+          p = _mm_xor_si128(p, _mm_loadu_si128((const __m128i *) (dst + x)));
+        }
+        _mm_storeu_si128((__m128i *) (dst + x), p);
+      }
+
+      row_scalar<accumulate>(dst + x, src + x, c, len - x);
+    }
+
+    template<bool accumulate>
+    __attribute__((target("avx2"))) void row_avx2(std::uint8_t *dst, const std::uint8_t *src, std::uint8_t c, std::size_t len) {
+      const auto *split = tables().split[c].data();
+
+      const auto lo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) split));
+      const auto hi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) (split + 16)));
+      const auto mask = _mm256_set1_epi8(0x0F);
+
+      std::size_t x = 0;
+      for (; x + 32 <= len; x += 32) {
+        auto s = _mm256_loadu_si256((const __m256i *) (src + x));
+        auto p = _mm256_xor_si256(
+          _mm256_shuffle_epi8(lo, _mm256_and_si256(s, mask)),
+          _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi64(s, 4), mask))
+        );
+        if constexpr (accumulate) {
+          p = _mm256_xor_si256(p, _mm256_loadu_si256((const __m256i *) (dst + x)));
+        }
+        _mm256_storeu_si256((__m256i *) (dst + x), p);
+      }
+
+      row_scalar<accumulate>(dst + x, src + x, c, len - x);
+    }
+
+    template<bool accumulate>
+    __attribute__((target("avx512f,avx512bw"))) void row_avx512(std::uint8_t *dst, const std::uint8_t *src, std::uint8_t c, std::size_t len) {
+      const auto *split = tables().split[c].data();
+
+      // The zero-masked forms avoid GCC 12 warnings about _mm512_undefined_epi32()
+      const auto lo = _mm512_maskz_broadcast_i32x4(0xFFFF, _mm_loadu_si128((const __m128i *) split));
+      const auto hi = _mm512_maskz_broadcast_i32x4(0xFFFF, _mm_loadu_si128((const __m128i *) (split + 16)));
+      const auto mask = _mm512_set1_epi8(0x0F);
+
+      std::size_t x = 0;
+      for (; x + 64 <= len; x += 64) {
+        auto s = _mm512_loadu_si512((const void *) (src + x));
+        auto p = _mm512_xor_si512(
+          _mm512_shuffle_epi8(lo, _mm512_and_si512(s, mask)),
+          _mm512_shuffle_epi8(hi, _mm512_and_si512(_mm512_maskz_srli_epi64(0xFF, s, 4), mask))
+        );
+        if constexpr (accumulate) {
+          p = _mm512_xor_si512(p, _mm512_loadu_si512((const void *) (dst + x)));
+        }
+        _mm512_storeu_si512((void *) (dst + x), p);
+      }
+
+      row_scalar<accumulate>(dst + x, src + x, c, len - x);
+    }
+#endif
+
+#ifdef GF256_NEON
+    template<bool accumulate>
+    void row_neon(std::uint8_t *dst, const std::uint8_t *src, std::uint8_t c, std::size_t len) {
+      const auto *split = tables().split[c].data();
+
+      const auto lo = vld1q_u8(split);
+      const auto hi = vld1q_u8(split + 16);
+      const auto mask = vdupq_n_u8(0x0F);
+
+      std::size_t x = 0;
+      for (; x + 16 <= len; x += 16) {
+        auto s = vld1q_u8(src + x);
+    #if defined(__aarch64__)
+        auto p = veorq_u8(vqtbl1q_u8(lo, vandq_u8(s, mask)), vqtbl1q_u8(hi, vshrq_n_u8(s, 4)));
+    #else
+        auto lookup = [](uint8x16_t table, uint8x16_t idx) {
+          uint8x8x2_t t {{vget_low_u8(table), vget_high_u8(table)}};
+          return vcombine_u8(vtbl2_u8(t, vget_low_u8(idx)), vtbl2_u8(t, vget_high_u8(idx)));
+        };
+        auto p = veorq_u8(lookup(lo, vandq_u8(s, mask)), lookup(hi, vshrq_n_u8(s, 4)));
+    #endif
+        if constexpr (accumulate) {
+          p = veorq_u8(p, vld1q_u8(dst + x));
+        }
+        vst1q_u8(dst + x, p);
+      }
+
+      row_scalar<accumulate>(dst + x, src + x, c, len - x);
+    }
+#endif
+
+    /**
+     * @brief Overwriting and accumulating row kernels for one implementation.
+     */
+    struct kernel_t {
+      row_f mul;
+      row_f mul_add;
+    };
+
+    kernel_t kernel_for(kernel_e kernel) {
+      switch (kernel) {
+#ifdef GF256_X86
+        case kernel_e::ssse3:
+          return {row_ssse3<false>, row_ssse3<true>};
+        case kernel_e::avx2:
+          return {row_avx2<false>, row_avx2<true>};
+        case kernel_e::avx512:
+          return {row_avx512<false>, row_avx512<true>};
+#endif
+#ifdef GF256_NEON
+        case kernel_e::neon:
+          return {row_neon<false>, row_neon<true>};
+#endif
+        default:
+          return {row_scalar<false>, row_scalar<true>};
+      }
+    }
+  }  // namespace
+
+  /**
+   * @brief Return a human-readable name for a kernel.
+   */
+  std::string_view to_string(kernel_e kernel) {
+    switch (kernel) {
+      case kernel_e::scalar:
+        return "scalar";
+      case kernel_e::ssse3:
+        return "SSSE3";
+      case kernel_e::avx2:
+        return "AVX2";
+      case kernel_e::avx512:
+        return "AVX-512";
+      case kernel_e::neon:
+        return "NEON";
+    }
+
+    return "unknown";
+  }
+
+  /**
+   * @brief Check whether a kernel can run on this machine.
+   */
+  bool supported(kernel_e kernel) {
+    switch (kernel) {
+      case kernel_e::scalar:
+        return true;
+#ifdef GF256_X86
+      case kernel_e::ssse3:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("ssse3");
+      case kernel_e::avx2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+      case kernel_e::avx512:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+#ifdef GF256_NEON
+      case kernel_e::neon:
+        return true;
+#endif
+      default:
+        return false;
+    }
+  }
+
+  /**
+   * @brief Select the widest supported kernel the first time it is requested.
+   */
+  kernel_e active_kernel() {
+    static const auto kernel = []() {
+      for (auto candidate : {kernel_e::avx512, kernel_e::avx2, kernel_e::ssse3, kernel_e::neon}) {
+        if (supported(candidate)) {
+          return candidate;
+        }
+      }
+
+      return kernel_e::scalar;
+    }();
+
+    return kernel;
+  }
+
+  /**
+   * @brief Multiply two GF(256) elements.
+   */
+  std::uint8_t mul(std::uint8_t a, std::uint8_t b) {
+    return tables().mul[a][b];
+  }
+
+  /**
+   * @brief Compute parity shards row by row with the requested kernel.
+   */
+  void encode(kernel_e kernel, const std::uint8_t *matrix, int data_shards, int parity_shards, std::uint8_t **shards, std::size_t blocksize) {
+    auto k = kernel_for(kernel);
+
+    for (int i = 0; i < parity_shards; ++i) {
+      auto *parity = shards[data_shards + i];
+      const auto *row = &matrix[i * data_shards];
+
+      k.mul(parity, shards[0], row[0], blocksize);
+      for (int j = 1; j < data_shards; ++j) {
+        k.mul_add(parity, shards[j], row[j], blocksize);
+      }
+    }
+  }
+
+  /**
+   * @brief Compute parity shards with the active kernel.
+   */
+  void encode(const std::uint8_t *matrix, int data_shards, int parity_shards, std::uint8_t **shards, std::size_t blocksize) {
+    encode(active_kernel(), matrix, data_shards, parity_shards, shards, blocksize);
+  }
+}  // namespace gf256
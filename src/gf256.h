@@ -0,0 +1,81 @@
+/**
+ * @file src/gf256.h
+ * @brief Declarations for GF(256) Reed-Solomon parity kernels.
+ */
+#pragma once
+
+// standard includes
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace gf256 {
+  /**
+   * @brief Enumerates the multiply-accumulate kernel implementations.
+   */
+  enum class kernel_e : int {
+    scalar,  ///< Portable table lookup implementation
+    ssse3,  ///< x86 SSSE3 split-table implementation
+    avx2,  ///< x86 AVX2 split-table implementation
+    avx512,  ///< x86 AVX-512BW split-table implementation
+    neon,  ///< ARM NEON split-table implementation
+  };
+
+  /**
+   * @brief Return a human-readable name for a kernel.
+   *
+   * @param kernel Kernel implementation to name.
+   * @return Kernel name suitable for logging.
+   */
+  std::string_view to_string(kernel_e kernel);
+
+  /**
+   * @brief Check whether a kernel was compiled in and is supported by the running CPU.
+   *
+   * @param kernel Kernel implementation to check.
+   * @return True when the kernel can be used on this machine.
+   */
+  bool supported(kernel_e kernel);
+
+  /**
+   * @brief Return the fastest supported kernel, detected once through CPUID.
+   *
+   * @return Kernel used by encode() when no kernel is specified.
+   */
+  kernel_e active_kernel();
+
+  /**
+   * @brief Multiply two elements of GF(256) using the 0x11D field polynomial.
+   *
+   * @param a First factor.
+   * @param b Second factor.
+   * @return Product of the two factors.
+   */
+  std::uint8_t mul(std::uint8_t a, std::uint8_t b);
+
+  /**
+   * @brief Compute Reed-Solomon parity shards with a specific kernel.
+   *
+   * The parity matrix has the nanors layout: `parity_shards` rows of `data_shards`
+   * coefficients. Parity shards are overwritten, so they need no initialization.
+   *
+   * @param kernel Kernel implementation to use; must be supported().
+   * @param matrix Parity matrix coefficients.
+   * @param data_shards Number of data shards.
+   * @param parity_shards Number of parity shards.
+   * @param shards Data shard pointers followed by parity shard pointers.
+   * @param blocksize Size of each shard in bytes.
+   */
+  void encode(kernel_e kernel, const std::uint8_t *matrix, int data_shards, int parity_shards, std::uint8_t **shards, std::size_t blocksize);
+
+  /**
+   * @brief Compute Reed-Solomon parity shards with the active kernel.
+   *
+   * @param matrix Parity matrix coefficients.
+   * @param data_shards Number of data shards.
+   * @param parity_shards Number of parity shards.
+   * @param shards Data shard pointers followed by parity shard pointers.
+   * @param blocksize Size of each shard in bytes.
+   */
+  void encode(const std::uint8_t *matrix, int data_shards, int parity_shards, std::uint8_t **shards, std::size_t blocksize);
+}  // namespace gf256
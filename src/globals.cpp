@@ -4,9 +4,11 @@
  */
 // local includes
 #include "globals.h"
+#include "mail.h"
 
 safe::mail_t mail::man;
 thread_pool_util::ThreadPool task_pool;
+thread_pool_util::ThreadPool input_pool;
 bool display_cursor = true;
 
 #ifdef _WIN32
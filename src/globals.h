@@ -13,6 +13,11 @@
  */
 extern thread_pool_util::ThreadPool task_pool;
 
+/**
+ * @brief A single, high-priority thread that injects input and owns all input state.
+ */
+extern thread_pool_util::ThreadPool input_pool;
+
 /**
  * @brief A boolean flag to indicate whether the cursor should be displayed.
  */
@@ -27,38 +32,3 @@ extern bool display_cursor;
  */
 extern nvprefs::nvprefs_interface nvprefs_instance;
 #endif
-
-/**
- * @brief Handles process-wide communication.
- */
-namespace mail {
-/**
- * @def MAIL(x)
- * @brief Macro for MAIL.
- */
-#define MAIL(x) \
-  constexpr auto x = std::string_view { \
-    #x \
-  }
-
-  /**
-   * @brief A process-wide communication mechanism.
-   */
-  extern safe::mail_t man;
-
-  // Global mail
-  MAIL(shutdown);  ///< Shutdown.
-  MAIL(broadcast_shutdown);  ///< Broadcast shutdown.
-  MAIL(video_packets);  ///< Video packets.
-  MAIL(audio_packets);  ///< Audio packets.
-  MAIL(switch_display);  ///< Switch display.
-
-  // Local mail
-  MAIL(touch_port);  ///< Touch port.
-  MAIL(idr);  ///< IDR.
-  MAIL(invalidate_ref_frames);  ///< Invalidate ref frames.
-  MAIL(gamepad_feedback);  ///< Gamepad feedback.
-  MAIL(hdr);  ///< HDR.
-#undef MAIL
-
-}  // namespace mail
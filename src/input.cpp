@@ -14,9 +14,9 @@ extern "C" {
 #include <chrono>
 #include <cmath>
 #include <functional>
-#include <list>
 #include <memory>
 #include <mutex>
+#include <span>
 #include <string>
 #include <string_view>
 #include <thread>
@@ -29,7 +29,9 @@ extern "C" {
 #include "config.h"
 #include "globals.h"
 #include "input.h"
+#include "input_ring.h"
 #include "logging.h"
+#include "mail.h"
 #include "platform/common.h"
 #include "thread_pool.h"
 #include "utility.h"
@@ -192,8 +194,8 @@ namespace input {
 
     ~gamepad_t() {
       if (id >= 0) {
-        if (task_pool.running()) {
-          task_pool.push([id = this->id]() {
+        if (input_pool.running()) {
+          input_pool.push([id = this->id]() {
             ::input::free_gamepad(platf_input, id);
           });
         } else {
@@ -263,8 +265,8 @@ namespace input {
     safe::mail_raw_t::event_t<input::touch_port_t> touch_port_event;  ///< Touch port event.
     platf::feedback_queue_t feedback_queue;  ///< Queue used to deliver controller feedback to the platform backend.
 
-    std::list<std::vector<uint8_t>> input_queue;  ///< Pending raw input packets waiting for processing.
-    std::mutex input_queue_lock;  ///< Input queue lock.
+    input_ring::ring_t input_queue;  ///< Raw input packets waiting for the input thread.
+    input_ring::latency_histogram_t dispatch_latency;  ///< Time from receiving input packets to injecting them.
 
     thread_pool_util::ThreadPool::task_id_t mouse_left_button_timeout;  ///< Mouse left button timeout.
 
@@ -323,8 +325,8 @@ namespace input {
    */
   template<typename Function>
   void dispatch_input_task(Function &&function) {
-    if (task_pool.running()) {
-      task_pool.push(std::forward<Function>(function));
+    if (input_pool.running()) {
+      input_pool.push(std::forward<Function>(function));
     } else {
       std::forward<Function>(function)();
     }
@@ -338,7 +340,7 @@ namespace input {
   void destroy_gamepads(const std::shared_ptr<input_t> &input) {
     for (auto &gamepad : input->gamepads) {
       if (gamepad.back_timeout_id) {
-        task_pool.cancel(gamepad.back_timeout_id);
+        input_pool.cancel(gamepad.back_timeout_id);
         gamepad.back_timeout_id = nullptr;
       }
       if (gamepad.id >= 0) {
@@ -881,7 +883,7 @@ namespace input {
         input->mouse_left_button_timeout = nullptr;
       };
 
-      input->mouse_left_button_timeout = task_pool.pushDelayed(std::move(f), 10ms).task_id;
+      input->mouse_left_button_timeout = input_pool.pushDelayed(std::move(f), 10ms).task_id;
 
       return;
     }
@@ -1031,7 +1033,7 @@ namespace input {
 
     send_key_and_modifiers(key_code, false, flags, synthetic_modifiers);
 
-    key_press_repeat_id = task_pool.pushDelayed(repeat_key, config::input.key_repeat_period, key_code, flags, synthetic_modifiers).task_id;
+    key_press_repeat_id = input_pool.pushDelayed(repeat_key, config::input.key_repeat_period, key_code, flags, synthetic_modifiers).task_id;
   }
 
   /**
@@ -1085,11 +1087,11 @@ namespace input {
         }
 
         if (key_press_repeat_id) {
-          task_pool.cancel(key_press_repeat_id);
+          input_pool.cancel(key_press_repeat_id);
         }
 
         if (config::input.key_repeat_delay.count() > 0) {
-          key_press_repeat_id = task_pool.pushDelayed(repeat_key, config::input.key_repeat_delay, keyCode, packet->flags, synthetic_modifiers).task_id;
+          key_press_repeat_id = input_pool.pushDelayed(repeat_key, config::input.key_repeat_delay, keyCode, packet->flags, synthetic_modifiers).task_id;
         }
       } else {
         // Already released
@@ -1544,10 +1546,10 @@ namespace input {
             gamepad.back_timeout_id = nullptr;
           };
 
-          gamepad.back_timeout_id = task_pool.pushDelayed(std::move(f), config::input.back_button_timeout).task_id;
+          gamepad.back_timeout_id = input_pool.pushDelayed(std::move(f), config::input.back_button_timeout).task_id;
         }
       } else if (gamepad.back_timeout_id) {
-        task_pool.cancel(gamepad.back_timeout_id);
+        input_pool.cancel(gamepad.back_timeout_id);
         gamepad.back_timeout_id = nullptr;
       }
     }
@@ -1838,54 +1840,14 @@ namespace input {
   }
 
   /**
-   * @brief Called on a thread pool thread to process an input message.
+   * @brief Send an input message to the OS.
    * @param input The input context pointer.
+   * @param payload The input message, after batching.
    */
-  void passthrough_next_message(std::shared_ptr<input_t> input) {
-    // 'entry' backs the 'payload' pointer, so they must remain in scope together
-    std::vector<uint8_t> entry;
-    PNV_INPUT_HEADER payload;
-
-    // Lock the input queue while batching, but release it before sending
-    // the input to the OS. This avoids potentially lengthy lock contention
-    // in the control stream thread while input is being processed by the OS.
-    {
-      std::lock_guard<std::mutex> lg(input->input_queue_lock);
-
-      // If all entries have already been processed, nothing to do
-      if (input->input_queue.empty()) {
-        return;
-      }
-
-      // Pop off the first entry, which we will send
-      entry = input->input_queue.front();
-      payload = (PNV_INPUT_HEADER) entry.data();
-      input->input_queue.pop_front();
-
-      // Try to batch with remaining items on the queue
-      auto i = input->input_queue.begin();
-      while (i != input->input_queue.end()) {
-        auto batchable_entry = *i;
-        auto batchable_payload = (PNV_INPUT_HEADER) batchable_entry.data();
-
-        auto batch_result = batch(payload, batchable_payload);
-        if (batch_result == batch_result_e::terminate_batch) {
-          // Stop batching
-          break;
-        } else if (batch_result == batch_result_e::batched) {
-          // Erase this entry since it was batched
-          i = input->input_queue.erase(i);
-        } else {
-          // We couldn't batch this entry, but try to batch later entries.
-          i++;
-        }
-      }
-    }
-
+  void inject(std::shared_ptr<input_t> &input, PNV_INPUT_HEADER payload) {
     // Print the final input packet
     input::print((void *) payload);
 
-    // Send the batched input to the OS
     switch (util::endian::little(payload->magic)) {
       case MOUSE_MOVE_REL_MAGIC_GEN5:
         passthrough(input, (PNV_REL_MOUSE_MOVE_PACKET) payload);
@@ -1934,17 +1896,80 @@ namespace input {
     }
   }
 
+  /**
+   * @brief Called on the input thread to batch and inject every queued input message.
+   * @param input The input context pointer.
+   */
+  void drain_input_queue(std::shared_ptr<input_t> input) {
+    // Reused for every session, so the buffers swapped in and out of the rings stay allocated
+    thread_local std::vector<input_ring::packet_t> packets;
+    thread_local std::vector<input_ring::clock::time_point> batched;  // Receive times of the messages batched into the current one
+
+    // The ring is only locked while its packets are swapped into the batch, the control
+    // stream thread never waits for batching or for the OS to process input.
+    while (auto queued = input->input_queue.take(packets)) {
+      for (std::size_t x = 0; x < queued; ++x) {
+        // Emptied after being batched into an earlier message
+        if (packets[x].data.empty()) {
+          continue;
+        }
+
+        auto payload = (PNV_INPUT_HEADER) packets[x].data.data();
+
+        // Try to batch with the messages queued after it
+        batched.clear();
+        for (std::size_t y = x + 1; y < queued; ++y) {
+          if (packets[y].data.empty()) {
+            continue;
+          }
+
+          auto batch_result = batch(payload, (PNV_INPUT_HEADER) packets[y].data.data());
+          if (batch_result == batch_result_e::terminate_batch) {
+            // Stop batching
+            break;
+          } else if (batch_result == batch_result_e::batched) {
+            // Empty it since it was batched
+            batched.emplace_back(packets[y].received);
+            packets[y].data.clear();
+          }
+
+          // We couldn't batch this entry, but try to batch later entries.
+        }
+
+        inject(input, payload);
+
+        // Batched messages were injected along with this one
+        auto injected = input_ring::clock::now();
+        input->dispatch_latency.record(injected - packets[x].received);
+        for (auto received : batched) {
+          input->dispatch_latency.record(injected - received);
+        }
+      }
+    }
+  }
+
   /**
    * @brief Called on the control stream thread to queue an input message.
    * @param input The input context pointer.
    * @param input_data The input message.
+   * @param received The time the message was received.
    */
-  void passthrough(std::shared_ptr<input_t> &input, std::vector<std::uint8_t> &&input_data) {
-    {
-      std::lock_guard<std::mutex> lg(input->input_queue_lock);
-      input->input_queue.push_back(std::move(input_data));
+  void passthrough(std::shared_ptr<input_t> &input, std::span<const std::uint8_t> input_data, std::chrono::steady_clock::time_point received) {
+    if (input_data.size() < sizeof(NV_INPUT_HEADER)) {
+      BOOST_LOG(warning) << "Input: Runt packet"sv;
+      return;
+    }
+
+    // Only the push that finds no drain pending schedules one, the rest are picked up by it
+    if (!input->input_queue.push(input_data, received)) {
+      return;
+    }
+
+    if (input_pool.running()) {
+      input_pool.push(drain_input_queue, input);
+    } else {
+      drain_input_queue(input);
     }
-    task_pool.push(passthrough_next_message, input);
   }
 
   /**
@@ -1980,7 +2005,7 @@ namespace input {
     for (int client_index = 0; client_index < input->gamepads.size(); ++client_index) {
       auto &gamepad = input->gamepads[client_index];
       if (gamepad.back_timeout_id) {
-        task_pool.cancel(gamepad.back_timeout_id);
+        input_pool.cancel(gamepad.back_timeout_id);
         gamepad.back_timeout_id = nullptr;
       }
       if (gamepad.id >= 0) {
@@ -2010,11 +2035,15 @@ namespace input {
    * @brief Reset the object to its initial empty state.
    */
   void reset(std::shared_ptr<input_t> &input) {
-    task_pool.cancel(key_press_repeat_id);
-    task_pool.cancel(input->mouse_left_button_timeout);
+    BOOST_LOG(debug) << "Input dispatch latency: "sv << input->dispatch_latency.to_string();
+    auto queue_stats = input->input_queue.stats();
+    BOOST_LOG(debug) << "Input queue: "sv << queue_stats.pushed << " packets, "sv << queue_stats.high_water << " queued at most, grown "sv << queue_stats.grown << " times"sv;
+
+    input_pool.cancel(key_press_repeat_id);
+    input_pool.cancel(input->mouse_left_button_timeout);
 
-    // Ensure input is synchronous, by using the task_pool
-    task_pool.push(reset_input_state, input);
+    // Ensure input is synchronous, by using the input thread
+    input_pool.push(reset_input_state, input);
   }
 
   void terminate_gamepads() {
@@ -2119,7 +2148,7 @@ namespace input {
     }
 
     // Workaround to ensure new frames will be captured when a client connects
-    task_pool.pushDelayed([]() {
+    input_pool.pushDelayed([]() {
       platf::move_mouse(platf_input, 1, 1);
       platf::move_mouse(platf_input, -1, -1);
     },
@@ -5,7 +5,9 @@
 #pragma once
 
 // standard includes
+#include <chrono>
 #include <functional>
+#include <span>
 #include <string_view>
 
 // local includes
@@ -45,8 +47,14 @@ namespace input {
 
   /**
    * @brief Queue a raw input message for platform passthrough.
+   *
+   * The message is copied, and injected later on the input thread.
+   *
+   * @param input Shared stream input state.
+   * @param input_data Raw input message.
+   * @param received Time the message was received, the start of its dispatch latency.
    */
-  void passthrough(std::shared_ptr<input_t> &input, std::vector<std::uint8_t> &&input_data);
+  void passthrough(std::shared_ptr<input_t> &input, std::span<const std::uint8_t> input_data, std::chrono::steady_clock::time_point received);
 
   /**
    * @brief Initialize global input resources and platform backends.
@@ -0,0 +1,165 @@
+/**
+ * @file src/input_ring.cpp
+ * @brief Definitions for the ring that carries input packets to the input thread.
+ */
+// standard includes
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <sstream>
+
+// local includes
+#include "input_ring.h"
+
+namespace input_ring {
+  ring_t::ring_t(std::size_t capacity):
+      _slots(std::max<std::size_t>(capacity, 1)) {
+  }
+
+  bool ring_t::push(std::span<const std::uint8_t> data, clock::time_point received) {
+    std::lock_guard lg {_lock};
+
+    if (_size == _slots.size()) {
+      grow();
+    }
+
+    // Reuses the capacity of whatever buffer the slot currently holds
+    auto &packet = _slots[(_read + _size) % _slots.size()];
+    packet.data.assign(std::begin(data), std::end(data));
+    packet.received = received;
+
+    ++_size;
+    ++_stats.pushed;
+    _stats.high_water = std::max<std::uint64_t>(_stats.high_water, _size);
+
+    if (_draining) {
+      return false;
+    }
+
+    _draining = true;
+    return true;
+  }
+
+  std::size_t ring_t::take(std::vector<packet_t> &batch) {
+    std::lock_guard lg {_lock};
+
+    auto taken = _size;
+    if (!taken) {
+      _draining = false;
+      return 0;
+    }
+
+    if (batch.size() < taken) {
+      batch.resize(taken);
+    }
+
+    for (std::size_t x = 0; x < taken; ++x) {
+      std::swap(batch[x], _slots[(_read + x) % _slots.size()]);
+    }
+
+    _read = (_read + taken) % _slots.size();
+    _size = 0;
+
+    return taken;
+  }
+
+  stats_t ring_t::stats() const {
+    std::lock_guard lg {_lock};
+
+    return _stats;
+  }
+
+  void ring_t::grow() {
+    std::vector<packet_t> slots(_slots.size() * 2);
+    for (std::size_t x = 0; x < _size; ++x) {
+      slots[x] = std::move(_slots[(_read + x) % _slots.size()]);
+    }
+
+    _slots = std::move(slots);
+    _read = 0;
+    ++_stats.grown;
+  }
+
+  void latency_histogram_t::record(clock::duration latency) {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+
+    // Under 2^x microseconds lands in bucket x
+    auto bucket = us <= 0 ? 0 : (std::size_t) std::bit_width((std::uint64_t) us);
+    _counts[std::min(bucket, BUCKETS - 1)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  std::array<std::uint64_t, latency_histogram_t::BUCKETS> latency_histogram_t::counts() const {
+    std::array<std::uint64_t, BUCKETS> counts;
+    for (std::size_t x = 0; x < BUCKETS; ++x) {
+      counts[x] = _counts[x].load(std::memory_order_relaxed);
+    }
+
+    return counts;
+  }
+
+  std::chrono::microseconds latency_histogram_t::percentile(double percentile) const {
+    auto bucket = percentile_bucket(counts(), percentile);
+    if (bucket == BUCKETS) {
+      return std::chrono::microseconds::zero();
+    }
+
+    return upper_bound(bucket);
+  }
+
+  std::string latency_histogram_t::to_string() const {
+    auto counts = this->counts();
+
+    auto bound = [](std::size_t bucket) {
+      if (bucket == BUCKETS) {
+        return std::string {"none"};
+      }
+      if (bucket == BUCKETS - 1) {
+        return ">=" + std::to_string(upper_bound(bucket - 1).count()) + "us";
+      }
+
+      return "<" + std::to_string(upper_bound(bucket).count()) + "us";
+    };
+
+    std::stringstream ss;
+    ss << "p50 " << bound(percentile_bucket(counts, 50)) << ", p99 " << bound(percentile_bucket(counts, 99)) << ", buckets";
+    for (std::size_t x = 0; x < BUCKETS; ++x) {
+      if (counts[x]) {
+        ss << ' ' << bound(x) << ':' << counts[x];
+      }
+    }
+
+    return ss.str();
+  }
+
+  std::chrono::microseconds latency_histogram_t::upper_bound(std::size_t bucket) {
+    if (bucket >= BUCKETS - 1) {
+      return std::chrono::microseconds::max();
+    }
+
+    return std::chrono::microseconds {std::uint64_t {1} << bucket};
+  }
+
+  std::size_t latency_histogram_t::percentile_bucket(const std::array<std::uint64_t, BUCKETS> &counts, double percentile) {
+    std::uint64_t total = 0;
+    for (auto count : counts) {
+      total += count;
+    }
+
+    if (!total) {
+      return BUCKETS;
+    }
+
+    // Rank of the sample at the percentile, starting at 1
+    auto rank = std::max<std::uint64_t>(1, (std::uint64_t) std::ceil(total * std::clamp(percentile, 0.0, 100.0) / 100.0));
+
+    std::uint64_t seen = 0;
+    for (std::size_t x = 0; x < BUCKETS; ++x) {
+      seen += counts[x];
+      if (seen >= rank) {
+        return x;
+      }
+    }
+
+    return BUCKETS - 1;
+  }
+}  // namespace input_ring
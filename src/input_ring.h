@@ -0,0 +1,153 @@
+/**
+ * @file src/input_ring.h
+ * @brief Declarations for the ring that carries input packets to the input thread.
+ */
+#pragma once
+
+// standard includes
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace input_ring {
+  using clock = std::chrono::steady_clock;
+
+  /**
+   * @brief Input packet waiting to be injected.
+   */
+  struct packet_t {
+    std::vector<std::uint8_t> data;  ///< Raw input message, starting with its NV_INPUT_HEADER.
+    clock::time_point received;  ///< Time the message was received on the control stream.
+  };
+
+  /**
+   * @brief Counters of a ring.
+   */
+  struct stats_t {
+    std::uint64_t pushed;  ///< Packets pushed by the control stream.
+    std::uint64_t high_water;  ///< Most packets queued at once.
+    std::uint64_t grown;  ///< Times the ring was full and had to grow.
+  };
+
+  /**
+   * @brief Ring of input packets, whose buffers are reused instead of allocated per packet.
+   *
+   * The consumer takes every queued packet at once, swapping the buffers it is done with
+   * back into the ring. Once the buffers are large enough for the packets of a session,
+   * neither side allocates anymore. Input can't be dropped without leaving keys or
+   * buttons stuck, so a full ring grows instead.
+   */
+  class ring_t {
+  public:
+    /**
+     * @brief Create an empty ring.
+     *
+     * @param capacity Number of packets queued before the ring grows.
+     */
+    explicit ring_t(std::size_t capacity = 64);
+
+    ring_t(const ring_t &) = delete;
+    ring_t &operator=(const ring_t &) = delete;
+
+    /**
+     * @brief Queue a copy of a packet.
+     *
+     * @param data Raw input message.
+     * @param received Time the message was received.
+     * @return `true` if no consumer is draining the ring, and one must be scheduled.
+     */
+    bool push(std::span<const std::uint8_t> data, clock::time_point received);
+
+    /**
+     * @brief Take every queued packet, oldest first.
+     *
+     * The first packets of `batch` are swapped with the queued ones, its other entries are
+     * left alone so their buffers can be used again. When the ring is found empty, the
+     * consumer is done draining, and the next push() asks for a new one.
+     *
+     * @param batch Grown as needed, receives the packets.
+     * @return Number of packets taken.
+     */
+    std::size_t take(std::vector<packet_t> &batch);
+
+    /**
+     * @brief Counters since the ring was created.
+     *
+     * @return Ring statistics.
+     */
+    stats_t stats() const;
+
+  private:
+    void grow();
+
+    mutable std::mutex _lock;
+    std::vector<packet_t> _slots;
+    std::size_t _read {0};
+    std::size_t _size {0};
+
+    // Set by the push that schedules a consumer, cleared once the consumer finds the ring empty
+    bool _draining {false};
+
+    stats_t _stats {};
+  };
+
+  /**
+   * @brief Histogram of latencies in power of two buckets.
+   *
+   * Bucket `x` counts latencies under `2^x` microseconds, the last bucket counts the rest.
+   * Samples may be recorded and read from different threads.
+   */
+  class latency_histogram_t {
+  public:
+    static constexpr std::size_t BUCKETS = 18;  ///< Buckets up to 65ms, plus the overflow bucket.
+
+    /**
+     * @brief Count a sample.
+     *
+     * @param latency Measured latency.
+     */
+    void record(clock::duration latency);
+
+    /**
+     * @brief Number of samples in each bucket.
+     *
+     * @return Bucket counts.
+     */
+    std::array<std::uint64_t, BUCKETS> counts() const;
+
+    /**
+     * @brief Upper bound of the bucket holding a percentile.
+     *
+     * @param percentile Percentile between 0 and 100.
+     * @return Latency the percentile is under, or zero without samples.
+     */
+    std::chrono::microseconds percentile(double percentile) const;
+
+    /**
+     * @brief Describe the non-empty buckets and common percentiles, for the log.
+     *
+     * @return Human readable histogram.
+     */
+    std::string to_string() const;
+
+    /**
+     * @brief Upper bound of a bucket.
+     *
+     * @param bucket Index of the bucket.
+     * @return Latency the samples of the bucket are under, or `microseconds::max()` for the last bucket.
+     */
+    static std::chrono::microseconds upper_bound(std::size_t bucket);
+
+  private:
+    // Bucket of the percentile, or BUCKETS without samples
+    static std::size_t percentile_bucket(const std::array<std::uint64_t, BUCKETS> &counts, double percentile);
+
+    std::array<std::atomic<std::uint64_t>, BUCKETS> _counts {};
+  };
+}  // namespace input_ring
@@ -0,0 +1,67 @@
+/**
+ * @file src/mail.h
+ * @brief Declarations for the process-wide mailbox and its channels.
+ */
+#pragma once
+
+// standard includes
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// local includes
+#include "audio.h"
+#include "input.h"
+#include "platform/common.h"
+#include "rate_control.h"
+#include "thread_safe.h"
+
+// Payload types of the mail channels, video.h itself would pull ffmpeg in everywhere
+namespace video {
+  struct packet_raw_t;
+  struct hdr_info_raw_t;
+  using packet_t = std::unique_ptr<packet_raw_t>;
+  using hdr_info_t = std::unique_ptr<hdr_info_raw_t>;
+}  // namespace video
+
+/**
+ * @brief Handles process-wide communication.
+ */
+namespace mail {
+  constexpr auto first_id = __COUNTER__ + 1;  ///< Counter value of the first channel.
+
+/**
+ * @def MAIL(kind, x, ...)
+ * @brief Declare channel x of a mailbox, either an event or a queue of the given payload type.
+ *
+ * Channels are numbered in the order they are declared in.
+ */
+#define MAIL(kind, x, ...) \
+  constexpr auto x = safe::kind##_id_t<__VA_ARGS__> { \
+    {__COUNTER__ - first_id, #x} \
+  }
+
+  /**
+   * @brief A process-wide communication mechanism.
+   */
+  extern safe::mail_t man;
+
+  // Global mail
+  MAIL(event, shutdown, bool);  ///< Shutdown.
+  MAIL(event, broadcast_shutdown, bool);  ///< Broadcast shutdown.
+  MAIL(queue, video_packets, video::packet_t);  ///< Video packets.
+  MAIL(queue, audio_packets, audio::packet_t);  ///< Audio packets.
+  MAIL(event, switch_display, int);  ///< Switch display.
+
+  // Local mail
+  MAIL(event, touch_port, input::touch_port_t);  ///< Touch port.
+  MAIL(event, idr, bool);  ///< IDR.
+  MAIL(event, invalidate_ref_frames, std::pair<int64_t, int64_t>);  ///< Invalidate ref frames.
+  MAIL(event, bitrate, int);  ///< Target video bitrate.
+  MAIL(event, audio_settings, rate_control::audio_settings_t);  ///< Opus encoder settings.
+  MAIL(queue, gamepad_feedback, platf::gamepad_feedback_msg_t);  ///< Gamepad feedback.
+  MAIL(event, hdr, video::hdr_info_t);  ///< HDR.
+#undef MAIL
+
+  static_assert(__COUNTER__ - first_id <= safe::mail_raw_t::MAX_IDS, "too many mail channels");
+}  // namespace mail
@@ -20,9 +20,11 @@
 #include "confighttp.h"
 #include "display_device.h"
 #include "entry_handler.h"
+#include "gf256.h"
 #include "globals.h"
 #include "httpcommon.h"
 #include "logging.h"
+#include "mail.h"
 #include "main.h"
 #include "nvhttp.h"
 #include "process.h"
@@ -338,6 +340,13 @@ int main(int argc, char *argv[]) {
 
   task_pool.start(1);
 
+  // Input gets its own thread, so injection never waits behind unrelated tasks
+  input_pool.start(1);
+  input_pool.push([]() {
+    platf::set_thread_name("input::dispatch");
+    platf::adjust_thread_priority(platf::thread_priority_e::critical);
+  });
+
   // Create signal handler after logging has been initialized
   auto shutdown_event = mail::man->event<bool>(mail::shutdown);
   on_signal(SIGINT, [&force_shutdown, &display_device_deinit_guard, shutdown_event]() {
@@ -401,6 +410,7 @@ int main(int argc, char *argv[]) {
   }
 
   reed_solomon_init();
+  BOOST_LOG(info) << "Using "sv << gf256::to_string(gf256::active_kernel()) << " Reed-Solomon kernel"sv;
   auto input_deinit_guard = input::init();
 
   if (input::probe_gamepads()) {
@@ -470,6 +480,9 @@ int main(int argc, char *argv[]) {
   configThread.join();
   rtspThread.join();
 
+  input_pool.stop();
+  input_pool.join();
+
   task_pool.stop();
   task_pool.join();
 
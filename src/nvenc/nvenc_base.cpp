@@ -672,6 +672,10 @@ namespace NVENC_NAMESPACE {
                      << frame_size_format % (client_config.bitrate / 8. / client_config.framerate) << " kB";
     log_created_encoder(init_params, enc_config, config, client_config, buffer_format);
 
+    reconfigure_params.init_params = init_params;
+    reconfigure_params.enc_config = enc_config;
+    reconfigure_params.init_params.encodeConfig = &reconfigure_params.enc_config;
+
     encoder_state = {};
     fail_guard.disable();
     return true;
@@ -706,6 +710,7 @@ namespace NVENC_NAMESPACE {
 
     encoder_state = {};
     encoder_params = {};
+    reconfigure_params = {};
   }
 
   ::nvenc::nvenc_encoded_frame nvenc_base::encode_frame(uint64_t frame_index, bool force_idr) {
@@ -829,6 +834,36 @@ namespace NVENC_NAMESPACE {
     return true;
   }
 
+  bool nvenc_base::set_bitrate(uint32_t bitrate_kbps) {
+    if (!encoder || bitrate_kbps == 0) {
+      return false;
+    }
+
+    auto enc_config = reconfigure_params.enc_config;
+    auto &rc_params = enc_config.rcParams;
+    const uint32_t bitrate = bitrate_kbps * 1000;
+    if (rc_params.averageBitRate == bitrate) {
+      return true;
+    }
+
+    if (rc_params.vbvBufferSize > 0 && rc_params.averageBitRate > 0) {
+      rc_params.vbvBufferSize = static_cast<uint32_t>(static_cast<uint64_t>(rc_params.vbvBufferSize) * bitrate / rc_params.averageBitRate);
+    }
+    rc_params.averageBitRate = bitrate;
+
+    NV_ENC_RECONFIGURE_PARAMS reconfigure = {NV_ENC_RECONFIGURE_PARAMS_VER};
+    reconfigure.reInitEncodeParams = reconfigure_params.init_params;
+    reconfigure.reInitEncodeParams.encodeConfig = &enc_config;
+    if (nvenc_failed(nvenc->nvEncReconfigureEncoder(encoder, &reconfigure))) {
+      BOOST_LOG(error) << "NvEnc: NvEncReconfigureEncoder() failed: " << last_nvenc_error_string;
+      return false;
+    }
+
+    reconfigure_params.enc_config = enc_config;
+    BOOST_LOG(debug) << "NvEnc: bitrate changed to " << bitrate_kbps << " kbps";
+    return true;
+  }
+
   bool nvenc_base::nvenc_failed(NVENCSTATUS status) {
     last_nvenc_error_string.clear();
     if (status != NV_ENC_SUCCESS) {
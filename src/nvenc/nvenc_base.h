@@ -75,6 +75,15 @@ namespace NVENC_NAMESPACE {
      */
     bool invalidate_ref_frames(uint64_t first_frame, uint64_t last_frame) override;
 
+    /**
+     * @brief Change the average bitrate with `NvEncReconfigureEncoder()`.
+     *        The VBV buffer is scaled by the same factor, so it still holds the same number of frames.
+     * @param bitrate_kbps New bitrate in kilobits per second.
+     * @return `true` on success, `false` on error.
+     *         After error the encoder keeps its previous bitrate.
+     */
+    bool set_bitrate(uint32_t bitrate_kbps) override;
+
   protected:
     /**
      * @brief Required. Used for loading NvEnc library and setting `nvenc` variable with `NvEncodeAPICreateInstance()`.
@@ -330,6 +339,11 @@ namespace NVENC_NAMESPACE {
 
     NV_ENC_OUTPUT_PTR output_bitstream = nullptr;
 
+    struct {
+      NV_ENC_INITIALIZE_PARAMS init_params;
+      NV_ENC_CONFIG enc_config;
+    } reconfigure_params = {};  ///< Parameters the encoder was initialized with, reused by `set_bitrate()`.
+
     struct {
       uint64_t last_encoded_frame_index = 0;
       bool rfi_needs_confirmation = false;
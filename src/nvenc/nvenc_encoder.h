@@ -70,6 +70,14 @@ namespace nvenc {
      * @return `true` on success, `false` on error.
      */
     virtual bool invalidate_ref_frames(std::uint64_t first_frame, std::uint64_t last_frame) = 0;
+
+    /**
+     * @brief Change the average bitrate without recreating the encoder.
+     *
+     * @param bitrate_kbps New bitrate in kilobits per second.
+     * @return `true` on success, `false` on error.
+     */
+    virtual bool set_bitrate(std::uint32_t bitrate_kbps) = 0;
   };
 
 }  // namespace nvenc
@@ -0,0 +1,79 @@
+/**
+ * @file src/pacer.cpp
+ * @brief Definitions for the token bucket used to pace video packets.
+ */
+// standard includes
+#include <algorithm>
+
+// local includes
+#include "pacer.h"
+
+namespace pacer {
+  using namespace std::literals;
+
+  token_bucket_t::token_bucket_t(const params_t &params):
+      _params {params},
+      _tokens {(double) params.burst_bytes} {
+    _rate = floor_rate();
+  }
+
+  void token_bucket_t::set_bitrate(std::int64_t bitrate_kbps) {
+    _params.bitrate_kbps = bitrate_kbps;
+    _rate = std::max(_rate, floor_rate());
+  }
+
+  double token_bucket_t::floor_rate() const {
+    // kilobits to bytes, then scaled by the headroom percentage
+    return (double) _params.bitrate_kbps * 1000 / 8 * _params.headroom_percent / 100;
+  }
+
+  void token_bucket_t::begin_frame(std::size_t frame_bytes, clock::time_point now) {
+    refill(now);
+
+    _rate = floor_rate();
+    if (_params.spread_percent > 0 && _params.frame_interval > 0ns) {
+      auto spread = std::chrono::duration<double>(_params.frame_interval).count() * _params.spread_percent / 100;
+      _rate = std::max(_rate, frame_bytes / spread);
+    }
+  }
+
+  void token_bucket_t::refill(clock::time_point now) {
+    if (now > _last) {
+      _tokens += std::chrono::duration<double>(now - _last).count() * _rate;
+      _tokens = std::min(_tokens, (double) _params.burst_bytes);
+      _last = now;
+    }
+  }
+
+  token_bucket_t::clock::time_point token_bucket_t::reserve(std::size_t bytes, clock::time_point now) {
+    // Without a rate there is nothing to pace against
+    if (_rate <= 0) {
+      return now;
+    }
+
+    refill(now);
+    _tokens -= bytes;
+
+    return std::max(ready_at(), now);
+  }
+
+  void stats_t::record(std::chrono::nanoseconds delay) {
+    ++batches;
+
+    if (delay <= 0ns) {
+      return;
+    }
+
+    ++delayed_batches;
+    total_delay += delay;
+    max_delay = std::max(max_delay, delay);
+  }
+
+  token_bucket_t::clock::time_point token_bucket_t::ready_at() const {
+    if (_tokens >= 0 || _rate <= 0) {
+      return _last;
+    }
+
+    return _last + std::chrono::round<clock::duration>(std::chrono::duration<double>(-_tokens / _rate));
+  }
+}  // namespace pacer
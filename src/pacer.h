@@ -0,0 +1,123 @@
+/**
+ * @file src/pacer.h
+ * @brief Declarations for the token bucket used to pace video packets.
+ */
+#pragma once
+
+// standard includes
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace pacer {
+  /**
+   * @brief Parameters of a token bucket pacer.
+   */
+  struct params_t {
+    std::int64_t bitrate_kbps;  ///< Negotiated video bitrate in kilobits per second.
+    int headroom_percent;  ///< Minimum send rate as a percentage of the negotiated bitrate.
+    std::size_t burst_bytes;  ///< Bucket capacity, the most that may be sent back-to-back.
+    std::chrono::nanoseconds frame_interval;  ///< Time between two frames at the negotiated framerate.
+    int spread_percent;  ///< Part of the frame interval each frame should be spread over, or 0 to disable.
+  };
+
+  /**
+   * @brief Counters describing how much pacing delayed the sends of a video sender.
+   */
+  struct stats_t {
+    std::uint64_t batches;  ///< Number of reservations.
+    std::uint64_t delayed_batches;  ///< Number of reservations that had to wait for tokens.
+    std::chrono::nanoseconds total_delay;  ///< Sum of the waits of every reservation.
+    std::chrono::nanoseconds max_delay;  ///< Longest wait of a single reservation.
+
+    /**
+     * @brief Count a reservation.
+     *
+     * @param delay Time the batch had to wait for tokens, zero if it could be sent right away.
+     */
+    void record(std::chrono::nanoseconds delay);
+  };
+
+  /**
+   * @brief Token bucket that paces the packets of a stream.
+   *
+   * Tokens are bytes. They accumulate at the current rate up to the burst size and
+   * sending takes them away. A send that takes more tokens than are available leaves
+   * the bucket in debt and must wait until the debt is paid back.
+   *
+   * The rate is chosen per frame: at least the negotiated bitrate scaled by the headroom,
+   * and fast enough to send the whole frame within the spread part of the frame interval.
+   */
+  class token_bucket_t {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    token_bucket_t() = default;
+
+    /**
+     * @brief Create a pacer with a full bucket.
+     *
+     * @param params Pacing parameters.
+     */
+    explicit token_bucket_t(const params_t &params);
+
+    /**
+     * @brief Update the negotiated bitrate, e.g. after the encoder bitrate was changed.
+     *
+     * @param bitrate_kbps New bitrate in kilobits per second.
+     */
+    void set_bitrate(std::int64_t bitrate_kbps);
+
+    /**
+     * @brief Choose the send rate for a new frame.
+     *
+     * @param frame_bytes Bytes that will be sent for the frame, including headers and parity.
+     * @param now Current time.
+     */
+    void begin_frame(std::size_t frame_bytes, clock::time_point now);
+
+    /**
+     * @brief Take tokens for a batch of packets.
+     *
+     * @param bytes Bytes about to be sent.
+     * @param now Current time.
+     * @return Time at which the batch may be sent, `now` when no wait is needed.
+     */
+    clock::time_point reserve(std::size_t bytes, clock::time_point now);
+
+    /**
+     * @brief Time at which the debt of the bucket will be paid back.
+     *
+     * @return Earliest time the next send could go out without waiting.
+     */
+    clock::time_point ready_at() const;
+
+    /**
+     * @brief Current send rate.
+     *
+     * @return Rate in bytes per second.
+     */
+    double rate() const {
+      return _rate;
+    }
+
+    /**
+     * @brief Bucket capacity.
+     *
+     * @return Burst size in bytes.
+     */
+    std::size_t burst() const {
+      return _params.burst_bytes;
+    }
+
+  private:
+    void refill(clock::time_point now);
+    double floor_rate() const;
+
+    params_t _params {};
+
+    double _rate = 0;
+    double _tokens = 0;
+    clock::time_point _last;
+  };
+}  // namespace pacer
@@ -0,0 +1,69 @@
+/**
+ * @file src/packet_arena.cpp
+ * @brief Definitions for the arena that recycles packet buffers of a video sender.
+ */
+// standard includes
+#include <bit>
+
+// local includes
+#include "packet_arena.h"
+
+namespace packet_arena {
+  namespace {
+    std::size_t class_size(std::size_t size_class) {
+      return arena_t::MIN_CLASS_SIZE << size_class;
+    }
+
+    std::size_t size_class_of(std::size_t bytes) {
+      if (bytes <= arena_t::MIN_CLASS_SIZE) {
+        return 0;
+      }
+
+      // Smallest power of two that fits, counted from the smallest class
+      return std::bit_width(bytes - 1) - std::bit_width(arena_t::MIN_CLASS_SIZE - 1);
+    }
+  }  // namespace
+
+  void block_t::release() {
+    if (_arena) {
+      std::exchange(_arena, nullptr)->release(_size_class, std::move(_storage));
+    }
+    _storage.reset();
+  }
+
+  arena_t::arena_t() {
+    // Giving a buffer back must not allocate either
+    for (auto &free : _free) {
+      free.reserve(MAX_FREE_PER_CLASS);
+    }
+  }
+
+  block_t arena_t::acquire(std::size_t bytes) {
+    ++_stats.acquired;
+
+    auto size_class = size_class_of(bytes);
+    if (size_class < SIZE_CLASSES && !_free[size_class].empty()) {
+      auto storage = std::move(_free[size_class].back());
+      _free[size_class].pop_back();
+      _stats.pooled_bytes -= class_size(size_class);
+
+      return {this, size_class, std::move(storage)};
+    }
+
+    ++_stats.allocations;
+    if (size_class >= SIZE_CLASSES) {
+      // Too large to be pooled, the block is freed when it is given back
+      return {nullptr, size_class, std::make_unique_for_overwrite<std::byte[]>(bytes)};
+    }
+
+    return {this, size_class, std::make_unique_for_overwrite<std::byte[]>(class_size(size_class))};
+  }
+
+  void arena_t::release(std::size_t size_class, std::unique_ptr<std::byte[]> storage) {
+    auto &free = _free[size_class];
+    if (free.size() < MAX_FREE_PER_CLASS) {
+      free.emplace_back(std::move(storage));
+      _stats.pooled_bytes += class_size(size_class);
+    }
+  }
+}  // namespace packet_arena
@@ -0,0 +1,269 @@
+/**
+ * @file src/packet_arena.h
+ * @brief Declarations for the arena that recycles packet buffers of a video sender.
+ */
+#pragma once
+
+// standard includes
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace packet_arena {
+  /**
+   * @brief Allocation counters of an arena.
+   */
+  struct stats_t {
+    std::uint64_t acquired;  ///< Buffers handed out by the arena.
+    std::uint64_t allocations;  ///< Buffers that had to be allocated from the heap.
+    std::size_t pooled_bytes;  ///< Bytes held by free buffers waiting to be reused.
+  };
+
+  class arena_t;
+
+  /**
+   * @brief Memory borrowed from an arena, given back when released or destroyed.
+   */
+  class block_t {
+  public:
+    block_t() = default;
+
+    /**
+     * @brief Take over the memory of another block.
+     *
+     * @param other Block left empty.
+     */
+    block_t(block_t &&other) noexcept:
+        _arena {std::exchange(other._arena, nullptr)},
+        _size_class {other._size_class},
+        _storage {std::move(other._storage)} {
+    }
+
+    /**
+     * @brief Swap the memory with another block.
+     *
+     * @param other Block that gets the previous memory of this one.
+     * @return This block.
+     */
+    block_t &operator=(block_t &&other) noexcept {
+      std::swap(_arena, other._arena);
+      std::swap(_size_class, other._size_class);
+      std::swap(_storage, other._storage);
+
+      return *this;
+    }
+
+    ~block_t() {
+      release();
+    }
+
+    /**
+     * @brief Give the memory back to its arena.
+     */
+    void release();
+
+    /**
+     * @brief Start of the borrowed memory.
+     *
+     * @return Pointer to the memory, or nullptr if nothing is borrowed.
+     */
+    std::byte *data() const {
+      return _storage.get();
+    }
+
+  private:
+    friend class arena_t;
+
+    block_t(arena_t *arena, std::size_t size_class, std::unique_ptr<std::byte[]> storage):
+        _arena {arena},
+        _size_class {size_class},
+        _storage {std::move(storage)} {
+    }
+
+    arena_t *_arena = nullptr;
+    std::size_t _size_class = 0;
+    std::unique_ptr<std::byte[]> _storage;
+  };
+
+  /**
+   * @brief Recycles buffers in power of two size classes.
+   *
+   * Buffers given back to the arena are kept on a free list of their size class and handed
+   * out again for later requests of that class, so a sender that keeps sending frames of
+   * similar sizes stops allocating once every class it needs has been filled.
+   *
+   * The arena isn't thread-safe. Buffers must be acquired and given back on the thread that
+   * owns it, but may be read and written from other threads in between.
+   */
+  class arena_t {
+  public:
+    /**
+     * @brief Size of the smallest size class.
+     */
+    static constexpr std::size_t MIN_CLASS_SIZE = 256;
+
+    /**
+     * @brief Number of size classes. Larger requests are allocated and freed every time.
+     */
+    static constexpr std::size_t SIZE_CLASSES = 16;
+
+    /**
+     * @brief Free buffers kept per size class, extra buffers given back are freed.
+     */
+    static constexpr std::size_t MAX_FREE_PER_CLASS = 32;
+
+    arena_t();
+
+    arena_t(const arena_t &) = delete;
+    arena_t &operator=(const arena_t &) = delete;
+
+    /**
+     * @brief Borrow memory from the arena.
+     *
+     * The content of the memory is unspecified.
+     *
+     * @param bytes Minimum size of the memory.
+     * @return Borrowed memory, aligned for any fundamental type.
+     */
+    block_t acquire(std::size_t bytes);
+
+    /**
+     * @brief Allocation counters since the arena was created.
+     *
+     * @return Arena statistics.
+     */
+    const stats_t &stats() const {
+      return _stats;
+    }
+
+  private:
+    friend class block_t;
+
+    void release(std::size_t size_class, std::unique_ptr<std::byte[]> storage);
+
+    std::array<std::vector<std::unique_ptr<std::byte[]>>, SIZE_CLASSES> _free;
+    stats_t _stats {};
+  };
+
+  /**
+   * @brief Typed array borrowed from an arena, with the interface of util::buffer_t.
+   *
+   * @tparam T Element type, must be trivially copyable since no constructors are run.
+   */
+  template<class T>
+  class buffer_t {
+    static_assert(std::is_trivially_copyable_v<T>, "Arena buffers don't construct their elements");
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "Arena buffers are only aligned like operator new[]");
+
+  public:
+    buffer_t() = default;
+
+    /**
+     * @brief Borrow an uninitialized array from an arena.
+     *
+     * @param arena Arena to borrow from.
+     * @param elements Number of elements of the array.
+     */
+    buffer_t(arena_t &arena, std::size_t elements):
+        _els {elements},
+        _block {arena.acquire(elements * sizeof(T))} {
+    }
+
+    /**
+     * @brief Take over the array of another buffer.
+     *
+     * @param other Buffer left empty.
+     */
+    buffer_t(buffer_t &&other) noexcept:
+        _els {std::exchange(other._els, 0)},
+        _block {std::move(other._block)} {
+    }
+
+    /**
+     * @brief Swap the array with another buffer.
+     *
+     * @param other Buffer that gets the previous array of this one.
+     * @return This buffer.
+     */
+    buffer_t &operator=(buffer_t &&other) noexcept {
+      std::swap(_els, other._els);
+      std::swap(_block, other._block);
+
+      return *this;
+    }
+
+    /**
+     * @brief Access an element of the array.
+     *
+     * @param el Zero-based element index.
+     * @return Mutable reference to the element.
+     */
+    T &operator[](std::size_t el) {
+      return begin()[el];
+    }
+
+    /**
+     * @brief Access an element of the array.
+     *
+     * @param el Zero-based element index.
+     * @return Const reference to the element.
+     */
+    const T &operator[](std::size_t el) const {
+      return begin()[el];
+    }
+
+    /**
+     * @brief Number of elements of the array.
+     *
+     * @return Element count.
+     */
+    std::size_t size() const {
+      return _els;
+    }
+
+    /**
+     * @brief First element of the array.
+     *
+     * @return Pointer to the first element.
+     */
+    T *begin() {
+      return (T *) _block.data();
+    }
+
+    /**
+     * @brief First element of the array.
+     *
+     * @return Pointer to the first element.
+     */
+    const T *begin() const {
+      return (const T *) _block.data();
+    }
+
+    /**
+     * @brief Element past the end of the array.
+     *
+     * @return Pointer past the last element.
+     */
+    T *end() {
+      return begin() + _els;
+    }
+
+    /**
+     * @brief Element past the end of the array.
+     *
+     * @return Pointer past the last element.
+     */
+    const T *end() const {
+      return begin() + _els;
+    }
+
+  private:
+    std::size_t _els = 0;
+    block_t _block;
+  };
+}  // namespace packet_arena
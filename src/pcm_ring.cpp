@@ -0,0 +1,93 @@
+/**
+ * @file src/pcm_ring.cpp
+ * @brief Definitions for the ring that carries captured PCM frames to the audio encoder.
+ */
+// local includes
+#include "pcm_ring.h"
+
+namespace pcm_ring {
+  ring_t::ring_t(std::size_t frames, std::size_t frame_samples, clock::duration frame_duration):
+      _frames {frames},
+      _frame_samples {frame_samples},
+      _frame_duration {frame_duration},
+      _storage {std::make_unique<float[]>(frames * frame_samples)},
+      _timestamps {std::make_unique<clock::rep[]>(frames)} {
+  }
+
+  void ring_t::push(const float *frame, clock::time_point timestamp) {
+    auto write = _write.load(std::memory_order_relaxed);
+    auto read = _read.load(std::memory_order_acquire);
+
+    if (write - read >= _frames) {
+      // Drop the oldest frame, unless the consumer took it in the meantime
+      if (_read.compare_exchange_strong(read, read + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        _overruns.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    // A consumer may still be reading this slot for a frame that was just dropped
+    auto dest = slot(write);
+    for (std::size_t x = 0; x < _frame_samples; ++x) {
+      std::atomic_ref<float> {dest[x]}.store(frame[x], std::memory_order_relaxed);
+    }
+    std::atomic_ref<clock::rep> {_timestamps[write % _frames]}.store(timestamp.time_since_epoch().count(), std::memory_order_relaxed);
+
+    _write.store(write + 1, std::memory_order_release);
+
+    _signal.fetch_add(1, std::memory_order_release);
+    _signal.notify_one();
+  }
+
+  bool ring_t::pop(std::vector<float> &frame, clock::time_point &timestamp) {
+    frame.resize(_frame_samples);
+
+    bool waited = false;
+    while (true) {
+      auto signal = _signal.load(std::memory_order_acquire);
+      auto read = _read.load(std::memory_order_acquire);
+
+      if (read == _write.load(std::memory_order_acquire)) {
+        if (_stopped.load(std::memory_order_acquire)) {
+          return false;
+        }
+
+        waited = true;
+        _signal.wait(signal, std::memory_order_acquire);
+        continue;
+      }
+
+      auto src = slot(read);
+      for (std::size_t x = 0; x < _frame_samples; ++x) {
+        frame[x] = std::atomic_ref<float> {src[x]}.load(std::memory_order_relaxed);
+      }
+      timestamp = clock::time_point {clock::duration {std::atomic_ref<clock::rep> {_timestamps[read % _frames]}.load(std::memory_order_relaxed)}};
+
+      // If the producer dropped the frame while it was copied, the copy may be torn
+      if (_read.compare_exchange_strong(read, read + 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        // The consumer is usually ahead of capture and waits for every frame, that's only
+        // an underrun when the frame is still missing once it should have been captured
+        if (waited && _next_due != clock::time_point {} && clock::now() > _next_due) {
+          _underruns.fetch_add(1, std::memory_order_relaxed);
+        }
+        _next_due = timestamp + _frame_duration;
+
+        return true;
+      }
+    }
+  }
+
+  void ring_t::stop() {
+    _stopped.store(true, std::memory_order_release);
+
+    _signal.fetch_add(1, std::memory_order_release);
+    _signal.notify_all();
+  }
+
+  stats_t ring_t::stats() const {
+    return {
+      _write.load(std::memory_order_relaxed),
+      _overruns.load(std::memory_order_relaxed),
+      _underruns.load(std::memory_order_relaxed),
+    };
+  }
+}  // namespace pcm_ring
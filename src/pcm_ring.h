@@ -0,0 +1,118 @@
+/**
+ * @file src/pcm_ring.h
+ * @brief Declarations for the ring that carries captured PCM frames to the audio encoder.
+ */
+#pragma once
+
+// standard includes
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace pcm_ring {
+  /**
+   * @brief Counters of a ring.
+   */
+  struct stats_t {
+    std::uint64_t pushed;  ///< Frames pushed by the producer.
+    std::uint64_t overruns;  ///< Oldest frames dropped because the ring was full.
+    std::uint64_t underruns;  ///< Pops that waited for a frame until after it was due.
+  };
+
+  /**
+   * @brief Single-producer, single-consumer ring of fixed-size PCM frames.
+   *
+   * Pushing never blocks: when the ring is full, only the oldest frame is dropped to make
+   * room for the new one. Popping waits for a frame, or for the ring to be stopped.
+   *
+   * Samples are copied in and out with relaxed atomic accesses. A consumer that was still
+   * copying a frame when the producer dropped it notices and moves on to the next frame,
+   * without the producer ever waiting for it.
+   */
+  class ring_t {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Create an empty ring.
+     *
+     * @param frames Maximum number of frames queued at once.
+     * @param frame_samples Number of samples in a frame.
+     * @param frame_duration Time between two captured frames.
+     */
+    ring_t(std::size_t frames, std::size_t frame_samples, clock::duration frame_duration);
+
+    ring_t(const ring_t &) = delete;
+    ring_t &operator=(const ring_t &) = delete;
+
+    /**
+     * @brief Queue a frame, dropping the oldest one if the ring is full.
+     *
+     * Must only be called from the producer thread.
+     *
+     * @param frame Samples of the frame, at least `frame_samples()` of them.
+     * @param timestamp Time the frame was captured.
+     */
+    void push(const float *frame, clock::time_point timestamp);
+
+    /**
+     * @brief Take the oldest frame, waiting for one if the ring is empty.
+     *
+     * Must only be called from the consumer thread.
+     *
+     * @param frame Resized to `frame_samples()` and filled with the samples of the frame.
+     * @param timestamp Set to the time the frame was captured.
+     * @return `false` if the ring was stopped and no frames are left.
+     */
+    bool pop(std::vector<float> &frame, clock::time_point &timestamp);
+
+    /**
+     * @brief Wake the consumer and make pop() fail once the ring is empty.
+     */
+    void stop();
+
+    /**
+     * @brief Number of samples in a frame.
+     *
+     * @return Samples per frame.
+     */
+    std::size_t frame_samples() const {
+      return _frame_samples;
+    }
+
+    /**
+     * @brief Counters since the ring was created.
+     *
+     * @return Ring statistics.
+     */
+    stats_t stats() const;
+
+  private:
+    float *slot(std::uint64_t position) const {
+      return _storage.get() + (position % _frames) * _frame_samples;
+    }
+
+    std::size_t _frames;
+    std::size_t _frame_samples;
+    clock::duration _frame_duration;
+    std::unique_ptr<float[]> _storage;
+    std::unique_ptr<clock::rep[]> _timestamps;
+
+    // Positions only ever grow, the slot of a position is its remainder by the number of frames
+    std::atomic<std::uint64_t> _read {0};
+    std::atomic<std::uint64_t> _write {0};
+
+    // Bumped after each push and on stop, the consumer sleeps on it while the ring is empty
+    std::atomic<std::uint32_t> _signal {0};
+    std::atomic<bool> _stopped {false};
+
+    std::atomic<std::uint64_t> _overruns {0};
+    std::atomic<std::uint64_t> _underruns {0};
+
+    // Capture time of the last popped frame plus a frame, only touched by the consumer
+    clock::time_point _next_due {};
+  };
+}  // namespace pcm_ring
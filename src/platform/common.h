@@ -6,6 +6,7 @@
 
 // standard includes
 #include <bitset>
+#include <chrono>
 #include <filesystem>
 #include <functional>
 #include <mutex>
@@ -789,6 +790,15 @@ namespace platf {
      */
     virtual capture_e sample(std::vector<float> &frame_buffer) = 0;
 
+    /**
+     * @brief Time the last captured frame spent in the audio server before it was read.
+     *
+     * @return Measured capture latency, or an empty value if the backend can't measure it.
+     */
+    virtual std::optional<std::chrono::microseconds> capture_latency() {
+      return std::nullopt;
+    }
+
     virtual ~mic_t() = default;
   };
 
@@ -1010,6 +1020,20 @@ namespace platf {
     uint16_t target_port;  ///< Destination UDP port for outgoing packets.
     boost::asio::ip::address &source_address;  ///< Local source IP address for outgoing packets.
 
+    // Optional time at which the kernel should send the first message block.
+    // Only honored on sockets where enable_socket_txtime() succeeded.
+    std::chrono::steady_clock::time_point launch_time {};  ///< Launch time of the first packet block, or the epoch to send immediately.
+    std::chrono::nanoseconds block_interval {};  ///< Time between the launch times of consecutive packet blocks.
+
+    /**
+     * @brief Returns the launch time of a packet block in this batch.
+     * @param block The index of the block relative to block_offset.
+     * @return Time at which the kernel should send the block.
+     */
+    std::chrono::steady_clock::time_point launch_time_for_block(size_t block) const {
+      return launch_time + block_interval * (std::int64_t) block;
+    }
+
     /**
      * @brief Returns a payload buffer descriptor for the given payload offset.
      * @param offset The offset in the total payload data (bytes).
@@ -1081,6 +1105,28 @@ namespace platf {
    */
   std::unique_ptr<deinit_t> enable_socket_qos(uintptr_t native_socket, boost::asio::ip::address &address, uint16_t port, qos_data_type_e data_type, bool dscp_tagging);
 
+  /**
+   * @brief Let the kernel pace packets sent on the given socket.
+   *
+   * Once enabled, send_batch() attaches the launch time of each batch and the
+   * packet scheduler (e.g. the `fq` qdisc) holds the packets back until then.
+   *
+   * @param native_socket The native socket handle.
+   * @return `true` if the socket accepts launch times.
+   */
+  bool enable_socket_txtime(uintptr_t native_socket);
+
+  /**
+   * @brief Check whether the interface owning a local address sends packets at their launch time.
+   *
+   * Launch times are silently ignored unless the interface's packet scheduler honors
+   * them, e.g. the `fq` or `etf` qdisc, or one of them on every queue of a multiqueue root.
+   *
+   * @param address The local IP address of the interface.
+   * @return `true` if packets sent from the address are held back until their launch time.
+   */
+  bool interface_honors_txtime(const std::string_view &address);
+
   /**
    * @brief Open a url in the default web browser.
    * @param url The url to open.
@@ -4,6 +4,7 @@
  */
 // standard includes
 #include <bitset>
+#include <cstring>
 #include <sstream>
 #include <thread>
 
@@ -61,6 +62,103 @@ namespace platf {
     return result;
   }
 
+  /**
+   * @brief PulseAudio recording stream driven by a threaded mainloop.
+   *
+   * Unlike pa_simple, the stream reports how long captured audio waited in the server
+   * before it was read.
+   */
+  struct mic_stream_t: public mic_t {
+    util::safe_ptr<pa_threaded_mainloop, pa_threaded_mainloop_free> loop;  ///< Mainloop thread serving the stream.
+    util::safe_ptr<pa_context, pa_context_unref> ctx;  ///< Connection to the PulseAudio server.
+    util::safe_ptr<pa_stream, pa_stream_unref> stream;  ///< Recording stream.
+
+    std::size_t fragment_offset = 0;  ///< Bytes of the current server fragment already read.
+    std::optional<std::chrono::microseconds> latency;  ///< Latency measured after the last read.
+
+    ~mic_stream_t() override {
+      if (!loop) {
+        return;
+      }
+
+      pa_threaded_mainloop_stop(loop.get());
+      if (stream && PA_STREAM_IS_GOOD(pa_stream_get_state(stream.get()))) {
+        pa_stream_disconnect(stream.get());
+      }
+      if (ctx && PA_CONTEXT_IS_GOOD(pa_context_get_state(ctx.get()))) {
+        pa_context_disconnect(ctx.get());
+      }
+    }
+
+    /**
+     * @brief Deliver a captured audio sample to Sunshine's audio pipeline.
+     *
+     * @param sample_buf Sample buf.
+     * @return Capture status reported to the streaming pipeline.
+     */
+    capture_e sample(std::vector<float> &sample_buf) override {
+      auto dest = (std::uint8_t *) sample_buf.data();
+      auto remaining = sample_buf.size() * sizeof(float);
+
+      pa_threaded_mainloop_lock(loop.get());
+      auto fg = util::fail_guard([this]() {
+        pa_threaded_mainloop_unlock(loop.get());
+      });
+
+      while (remaining > 0) {
+        if (pa_stream_get_state(stream.get()) != PA_STREAM_READY) {
+          BOOST_LOG(error) << "PulseAudio recording stream failed: "sv << pa_strerror(pa_context_errno(ctx.get()));
+
+          return capture_e::error;
+        }
+
+        const void *data;
+        std::size_t bytes;
+        if (pa_stream_peek(stream.get(), &data, &bytes)) {
+          BOOST_LOG(error) << "pa_stream_peek() failed: "sv << pa_strerror(pa_context_errno(ctx.get()));
+
+          return capture_e::error;
+        }
+
+        // Nothing was captured yet, the read callback wakes us up
+        if (bytes == 0) {
+          pa_threaded_mainloop_wait(loop.get());
+          continue;
+        }
+
+        // A frame may end in the middle of a server fragment, the rest is read next time
+        auto count = std::min(bytes - fragment_offset, remaining);
+        if (data) {
+          std::memcpy(dest, (const std::uint8_t *) data + fragment_offset, count);
+        } else {
+          // A hole in the stream is heard as silence
+          std::memset(dest, 0, count);
+        }
+
+        dest += count;
+        remaining -= count;
+        fragment_offset += count;
+
+        if (fragment_offset == bytes) {
+          pa_stream_drop(stream.get());
+          fragment_offset = 0;
+        }
+      }
+
+      pa_usec_t usec;
+      int negative;
+      if (!pa_stream_get_latency(stream.get(), &usec, &negative)) {
+        latency = std::chrono::microseconds {negative ? 0 : usec};
+      }
+
+      return capture_e::ok;
+    }
+
+    std::optional<std::chrono::microseconds> capture_latency() override {
+      return latency;
+    }
+  };
+
   /**
    * @brief PulseAudio recording stream and channel metadata.
    */
@@ -88,6 +186,99 @@ namespace platf {
     }
   };
 
+  /**
+   * @brief Connect an asynchronous recording stream.
+   *
+   * @param ss Sample format of the stream.
+   * @param pa_map Channel layout of the stream.
+   * @param pa_attr Requested server-side buffering.
+   * @param source_name Source to record from.
+   * @return Recording stream, or nullptr if it couldn't be connected.
+   */
+  std::unique_ptr<mic_t> microphone_stream(const pa_sample_spec &ss, const pa_channel_map &pa_map, const pa_buffer_attr &pa_attr, const std::string &source_name) {
+    auto mic = std::make_unique<mic_stream_t>();
+
+    mic->loop.reset(pa_threaded_mainloop_new());
+    if (!mic->loop) {
+      BOOST_LOG(error) << "pa_threaded_mainloop_new() failed"sv;
+      return nullptr;
+    }
+
+    auto loop = mic->loop.get();
+    mic->ctx.reset(pa_context_new(pa_threaded_mainloop_get_api(loop), "sunshine"));
+    if (!mic->ctx) {
+      BOOST_LOG(error) << "pa_context_new() failed"sv;
+      return nullptr;
+    }
+
+    // Every state change and every captured fragment wakes up whoever waits on the mainloop
+    pa_context_set_state_callback(mic->ctx.get(), [](pa_context *, void *userdata) {
+      pa_threaded_mainloop_signal((pa_threaded_mainloop *) userdata, 0);
+    }, loop);
+
+    if (pa_threaded_mainloop_start(loop)) {
+      BOOST_LOG(error) << "pa_threaded_mainloop_start() failed"sv;
+      return nullptr;
+    }
+
+    // Unlocked before the stream is destroyed on failure, stopping the mainloop needs the lock
+    pa_threaded_mainloop_lock(loop);
+    auto fg = util::fail_guard([loop]() {
+      pa_threaded_mainloop_unlock(loop);
+    });
+
+    if (pa_context_connect(mic->ctx.get(), nullptr, PA_CONTEXT_NOFLAGS, nullptr)) {
+      BOOST_LOG(error) << "Couldn't connect to pulseaudio: "sv << pa_strerror(pa_context_errno(mic->ctx.get()));
+      return nullptr;
+    }
+
+    for (auto state = pa_context_get_state(mic->ctx.get()); state != PA_CONTEXT_READY; state = pa_context_get_state(mic->ctx.get())) {
+      if (!PA_CONTEXT_IS_GOOD(state)) {
+        BOOST_LOG(error) << "Couldn't connect to pulseaudio: "sv << pa_strerror(pa_context_errno(mic->ctx.get()));
+        return nullptr;
+      }
+
+      pa_threaded_mainloop_wait(loop);
+    }
+
+    mic->stream.reset(pa_stream_new(mic->ctx.get(), "sunshine-record", &ss, &pa_map));
+    if (!mic->stream) {
+      BOOST_LOG(error) << "pa_stream_new() failed: "sv << pa_strerror(pa_context_errno(mic->ctx.get()));
+      return nullptr;
+    }
+
+    pa_stream_set_state_callback(mic->stream.get(), [](pa_stream *, void *userdata) {
+      pa_threaded_mainloop_signal((pa_threaded_mainloop *) userdata, 0);
+    }, loop);
+    pa_stream_set_read_callback(mic->stream.get(), [](pa_stream *, std::size_t, void *userdata) {
+      pa_threaded_mainloop_signal((pa_threaded_mainloop *) userdata, 0);
+    }, loop);
+
+    // Same flags as pa_simple, the server sizes the source latency after the fragment size
+    auto flags = (pa_stream_flags_t) (PA_STREAM_ADJUST_LATENCY | PA_STREAM_AUTO_TIMING_UPDATE | PA_STREAM_INTERPOLATE_TIMING);
+    if (pa_stream_connect_record(mic->stream.get(), source_name.empty() ? nullptr : source_name.c_str(), &pa_attr, flags)) {
+      BOOST_LOG(error) << "pa_stream_connect_record() failed: "sv << pa_strerror(pa_context_errno(mic->ctx.get()));
+      return nullptr;
+    }
+
+    for (auto state = pa_stream_get_state(mic->stream.get()); state != PA_STREAM_READY; state = pa_stream_get_state(mic->stream.get())) {
+      if (!PA_STREAM_IS_GOOD(state)) {
+        BOOST_LOG(error) << "Couldn't record from ["sv << source_name << "]: "sv << pa_strerror(pa_context_errno(mic->ctx.get()));
+        return nullptr;
+      }
+
+      pa_threaded_mainloop_wait(loop);
+    }
+
+    // The server may not grant the requested buffering
+    if (auto attr = pa_stream_get_buffer_attr(mic->stream.get())) {
+      BOOST_LOG(info) << "Audio capture buffering: fragment "sv << pa_bytes_to_usec(attr->fragsize, &ss) / 1000.0 << " ms, maximum "sv
+                      << pa_bytes_to_usec(attr->maxlength, &ss) / 1000.0 << " ms"sv;
+    }
+
+    return mic;
+  }
+
   /**
    * @brief Create a microphone capture stream for the requested layout.
    *
@@ -99,8 +290,6 @@ namespace platf {
    * @return Microphone capture object for the requested audio layout.
    */
   std::unique_ptr<mic_t> microphone(const std::uint8_t *mapping, int channels, std::uint32_t sample_rate, std::uint32_t frame_size, std::string source_name) {
-    auto mic = std::make_unique<mic_attr_t>();
-
     pa_sample_spec ss {PA_SAMPLE_FLOAT32, sample_rate, (std::uint8_t) channels};
     pa_channel_map pa_map;
 
@@ -109,6 +298,7 @@ namespace platf {
       channel = position_mapping[*mapping++];
     });
 
+    // By default, the server delivers one audio packet at a time and keeps as much as it likes
     pa_buffer_attr pa_attr = {
       .maxlength = uint32_t(-1),
       .tlength = uint32_t(-1),
@@ -117,6 +307,21 @@ namespace platf {
       .fragsize = uint32_t(frame_size * channels * sizeof(float))
     };
 
+    if (config::audio.fragment > 0) {
+      pa_attr.fragsize = pa_usec_to_bytes(config::audio.fragment * PA_USEC_PER_MSEC, &ss);
+    }
+    if (config::audio.max_buffer > 0) {
+      pa_attr.maxlength = pa_usec_to_bytes(config::audio.max_buffer * PA_USEC_PER_MSEC, &ss);
+    }
+
+    if (auto mic = microphone_stream(ss, pa_map, pa_attr, source_name)) {
+      return mic;
+    }
+
+    BOOST_LOG(warning) << "Falling back to blocking audio capture"sv;
+
+    auto mic = std::make_unique<mic_attr_t>();
+
     int status;
 
     mic->mic.reset(
@@ -13,12 +13,16 @@
 #endif
 
 // standard includes
+#include <algorithm>
+#include <array>
 #include <cerrno>
 #include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <optional>
 #include <sstream>
+#include <vector>
 
 // platform includes
 #include <arpa/inet.h>
@@ -32,6 +36,10 @@
 #include <sys/socket.h>
 
 #if !defined(__FreeBSD__)
+  #include <linux/net_tstamp.h>  // For SO_TXTIME
+  #include <linux/pkt_sched.h>  // For TC_H_ROOT
+  #include <linux/rtnetlink.h>  // For RTM_GETQDISC
+  #include <net/if.h>  // For if_nametoindex
   #include <sys/capability.h>
   #include <sys/prctl.h>
 #endif
@@ -635,6 +643,18 @@ namespace platf {
     return saddr_v6;
   }
 
+  /**
+   * @brief Write a launch time into an SCM_TXTIME control message.
+   *
+   * @param txtime_cm Control message to fill in.
+   * @param launch_time Time at which the kernel should send the packets.
+   */
+  static void set_txtime(struct cmsghdr *txtime_cm, std::chrono::steady_clock::time_point launch_time) {
+    // SO_TXTIME is enabled with CLOCK_MONOTONIC, which is also the clock behind steady_clock on Linux
+    uint64_t txtime = std::chrono::duration_cast<std::chrono::nanoseconds>(launch_time.time_since_epoch()).count();
+    memcpy(CMSG_DATA(txtime_cm), &txtime, sizeof(txtime));
+  }
+
   /**
    * @brief Send multiple fixed-size UDP payload blocks using the platform backend.
    */
@@ -657,12 +677,12 @@ namespace platf {
       msg.msg_namelen = sizeof(taddr_v4);
     }
 
-    union {
+    union cmbuf_t {
 #ifdef IP_PKTINFO
-      char buf[CMSG_SPACE(sizeof(uint16_t)) + std::max(CMSG_SPACE(sizeof(struct in_pktinfo)), CMSG_SPACE(sizeof(struct in6_pktinfo)))];
+      char buf[CMSG_SPACE(sizeof(uint16_t)) + CMSG_SPACE(sizeof(uint64_t)) + std::max(CMSG_SPACE(sizeof(struct in_pktinfo)), CMSG_SPACE(sizeof(struct in6_pktinfo)))];
 #elif defined(IP_SENDSRCADDR)
       // FreeBSD uses IP_SENDSRCADDR with struct in_addr instead of IP_PKTINFO with struct in_pktinfo
-      char buf[CMSG_SPACE(sizeof(uint16_t)) + std::max(CMSG_SPACE(sizeof(struct in_addr)), CMSG_SPACE(sizeof(struct in6_pktinfo)))];
+      char buf[CMSG_SPACE(sizeof(uint16_t)) + CMSG_SPACE(sizeof(uint64_t)) + std::max(CMSG_SPACE(sizeof(struct in_addr)), CMSG_SPACE(sizeof(struct in6_pktinfo)))];
 #endif
       struct cmsghdr alignment;
     } cmbuf = {};  // Must be zeroed for CMSG_NXTHDR()
@@ -672,8 +692,9 @@ namespace platf {
     msg.msg_control = cmbuf.buf;
     msg.msg_controllen = sizeof(cmbuf.buf);
 
-    // The PKTINFO option will always be first, then we will conditionally
-    // append the UDP_SEGMENT option next if applicable.
+    // The PKTINFO option will always be first, followed by the SCM_TXTIME option
+    // if the batch has a launch time, then we will conditionally append the
+    // UDP_SEGMENT option next if applicable.
     auto pktinfo_cm = CMSG_FIRSTHDR(&msg);
     if (send_info.source_address.is_v6()) {
       struct in6_pktinfo pktInfo;
@@ -716,6 +737,19 @@ namespace platf {
 #endif
     }
 
+    auto last_cm = pktinfo_cm;
+    struct cmsghdr *txtime_cm = nullptr;
+#ifdef SCM_TXTIME
+    if (send_info.launch_time != std::chrono::steady_clock::time_point {}) {
+      txtime_cm = CMSG_NXTHDR(&msg, pktinfo_cm);
+      txtime_cm->cmsg_level = SOL_SOCKET;
+      txtime_cm->cmsg_type = SCM_TXTIME;
+      txtime_cm->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+      cmbuflen += CMSG_SPACE(sizeof(uint64_t));
+      last_cm = txtime_cm;
+    }
+#endif
+
     auto const max_iovs_per_msg = send_info.payload_buffers.size() + (send_info.headers ? 1 : 0);
 
 #ifdef UDP_SEGMENT
@@ -760,7 +794,7 @@ namespace platf {
           msg.msg_controllen = cmbuflen + CMSG_SPACE(sizeof(uint16_t));
 
           // Enable GSO to perform segmentation of our buffer for us
-          auto cm = CMSG_NXTHDR(&msg, pktinfo_cm);
+          auto cm = CMSG_NXTHDR(&msg, last_cm);
           cm->cmsg_level = SOL_UDP;
           cm->cmsg_type = UDP_SEGMENT;
           cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
@@ -769,6 +803,11 @@ namespace platf {
           msg.msg_controllen = cmbuflen;
         }
 
+        // Every GSO message is launched at the time of its first segment
+        if (txtime_cm) {
+          set_txtime(txtime_cm, send_info.launch_time_for_block(seg_index));
+        }
+
         // This will fail if GSO is not available, so we will fall back to non-GSO if
         // it's the first sendmsg() call. On subsequent calls, we will treat errors as
         // actual failures and return to the caller.
@@ -808,6 +847,9 @@ namespace platf {
       // If GSO is not supported, use sendmmsg() instead.
       std::vector<struct mmsghdr> msgs(send_info.block_count);
       std::vector<struct iovec> iovs(send_info.block_count * (send_info.headers ? 2 : 1));
+
+      // Messages with their own launch time need their own control buffers
+      std::vector<cmbuf_t> txtime_cmbufs(txtime_cm ? send_info.block_count : 0);
       int iov_idx = 0;
       for (size_t i = 0; i < send_info.block_count; i++) {
         msgs[i].msg_len = 0;
@@ -829,6 +871,13 @@ namespace platf {
         msgs[i].msg_hdr.msg_control = cmbuf.buf;
         msgs[i].msg_hdr.msg_controllen = cmbuflen;
         msgs[i].msg_hdr.msg_flags = 0;
+
+        if (txtime_cm) {
+          auto &msg_cmbuf = txtime_cmbufs[i];
+          msg_cmbuf = cmbuf;
+          set_txtime((struct cmsghdr *) (msg_cmbuf.buf + ((char *) txtime_cm - cmbuf.buf)), send_info.launch_time_for_block(i));
+          msgs[i].msg_hdr.msg_control = msg_cmbuf.buf;
+        }
       }
 
       // Call sendmmsg() until all messages are sent
@@ -1093,6 +1142,160 @@ namespace platf {
     return std::make_unique<qos_t>(sockfd, reset_options);
   }
 
+  /**
+   * @brief Enables kernel pacing with SO_TXTIME on the given socket.
+   */
+  bool enable_socket_txtime(uintptr_t native_socket) {
+#ifdef SO_TXTIME
+    // CLOCK_MONOTONIC is the clock the fq qdisc paces with, and it needs no extra privileges
+    struct sock_txtime txtime = {};
+    txtime.clockid = CLOCK_MONOTONIC;
+    txtime.flags = 0;
+
+    if (setsockopt((int) native_socket, SOL_SOCKET, SO_TXTIME, &txtime, sizeof(txtime)) == 0) {
+      return true;
+    }
+
+    BOOST_LOG(warning) << "Failed to set SO_TXTIME: "sv << errno;
+#else
+    BOOST_LOG(debug) << "SO_TXTIME not supported on this platform"sv;
+#endif
+    return false;
+  }
+
+#if defined(SO_TXTIME) && !defined(__FreeBSD__)
+  /**
+   * @brief Queueing discipline attached to a network interface.
+   */
+  struct qdisc_t {
+    std::uint32_t handle;  ///< Handle of the qdisc.
+    std::uint32_t parent;  ///< Handle of the class it is attached to, or TC_H_ROOT.
+    std::string kind;  ///< Name of the qdisc, e.g. "fq".
+  };
+
+  /**
+   * @brief List the queueing disciplines of an interface over rtnetlink.
+   *
+   * @param ifindex Index of the interface.
+   * @return The qdiscs of the interface, or an empty optional on failure.
+   */
+  static std::optional<std::vector<qdisc_t>> get_qdiscs(int ifindex) {
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) {
+      BOOST_LOG(warning) << "Couldn't open rtnetlink socket: "sv << errno;
+      return std::nullopt;
+    }
+    auto close_fd = util::fail_guard([fd]() {
+      close(fd);
+    });
+
+    struct {
+      nlmsghdr header;
+      tcmsg message;
+    } request {};
+
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(tcmsg));
+    request.header.nlmsg_type = RTM_GETQDISC;
+    request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.message.tcm_family = AF_UNSPEC;
+    request.message.tcm_ifindex = ifindex;
+
+    if (send(fd, &request, request.header.nlmsg_len, 0) < 0) {
+      BOOST_LOG(warning) << "Couldn't request qdiscs: "sv << errno;
+      return std::nullopt;
+    }
+
+    std::vector<qdisc_t> qdiscs;
+    alignas(nlmsghdr) std::array<char, 32 * 1024> buffer;
+    while (true) {
+      auto bytes = recv(fd, buffer.data(), buffer.size(), 0);
+      if (bytes < 0) {
+        BOOST_LOG(warning) << "Couldn't read qdiscs: "sv << errno;
+        return std::nullopt;
+      }
+
+      for (auto header = (nlmsghdr *) buffer.data(); NLMSG_OK(header, bytes); header = NLMSG_NEXT(header, bytes)) {
+        if (header->nlmsg_type == NLMSG_DONE) {
+          return qdiscs;
+        }
+        if (header->nlmsg_type == NLMSG_ERROR) {
+          BOOST_LOG(warning) << "Couldn't dump qdiscs"sv;
+          return std::nullopt;
+        }
+
+        // Older kernels dump the qdiscs of every interface
+        auto message = (tcmsg *) NLMSG_DATA(header);
+        if (header->nlmsg_type != RTM_NEWQDISC || message->tcm_ifindex != ifindex) {
+          continue;
+        }
+
+        qdisc_t qdisc {message->tcm_handle, message->tcm_parent, {}};
+        int attrs_len = TCA_PAYLOAD(header);
+        for (auto attr = TCA_RTA(message); RTA_OK(attr, attrs_len); attr = RTA_NEXT(attr, attrs_len)) {
+          if (attr->rta_type == TCA_KIND) {
+            qdisc.kind = (const char *) RTA_DATA(attr);
+          }
+        }
+        qdiscs.emplace_back(std::move(qdisc));
+      }
+    }
+  }
+#endif
+
+  bool interface_honors_txtime(const std::string_view &address) {
+#if defined(SO_TXTIME) && !defined(__FreeBSD__)
+    std::string interface_name;
+    auto ifaddrs = get_ifaddrs();
+    for (auto pos = ifaddrs.get(); pos != nullptr; pos = pos->ifa_next) {
+      if (pos->ifa_addr && address == from_sockaddr(pos->ifa_addr)) {
+        interface_name = pos->ifa_name;
+        break;
+      }
+    }
+
+    auto ifindex = interface_name.empty() ? 0 : (int) if_nametoindex(interface_name.c_str());
+    if (!ifindex) {
+      BOOST_LOG(debug) << "No interface found for address "sv << address;
+      return false;
+    }
+
+    auto qdiscs = get_qdiscs(ifindex);
+    if (!qdiscs) {
+      return false;
+    }
+
+    auto paces = [](const qdisc_t &qdisc) {
+      return qdisc.kind == "fq"sv || qdisc.kind == "etf"sv;
+    };
+
+    auto root = std::ranges::find(*qdiscs, TC_H_ROOT, &qdisc_t::parent);
+    if (root == std::end(*qdiscs)) {
+      return false;
+    }
+
+    // A multiqueue root hands every TX queue to a child qdisc of its own
+    if (root->kind == "mq"sv || root->kind == "mqprio"sv) {
+      bool children = false;
+      for (auto &qdisc : *qdiscs) {
+        if (qdisc.parent != TC_H_ROOT && TC_H_MAJ(qdisc.parent) == root->handle) {
+          if (!paces(qdisc)) {
+            BOOST_LOG(debug) << interface_name << " has a queue with the "sv << qdisc.kind << " qdisc"sv;
+            return false;
+          }
+          children = true;
+        }
+      }
+
+      return children;
+    }
+
+    BOOST_LOG(debug) << interface_name << " has the "sv << root->kind << " qdisc"sv;
+    return paces(*root);
+#else
+    return false;
+#endif
+  }
+
   std::string get_host_name() {
     try {
       return boost::asio::ip::host_name();
@@ -616,6 +616,20 @@ namespace platf {
     return std::make_unique<qos_t>(sockfd, reset_options);
   }
 
+  /**
+   * @brief Kernel pacing with SO_TXTIME is not available on this platform.
+   */
+  bool enable_socket_txtime(uintptr_t native_socket) {
+    return false;
+  }
+
+  /**
+   * @brief Kernel pacing with SO_TXTIME is not available on this platform.
+   */
+  bool interface_honors_txtime(const std::string_view &address) {
+    return false;
+  }
+
   std::string get_host_name() {
     try {
       return boost::asio::ip::host_name();
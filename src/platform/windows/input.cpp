@@ -376,7 +376,7 @@ namespace platf {
       auto &gamepad = gamepads[nr];
 
       if (gamepad.repeat_task) {
-        task_pool.cancel(gamepad.repeat_task);
+        input_pool.cancel(gamepad.repeat_task);
         gamepad.repeat_task = nullptr;
       }
 
@@ -494,7 +494,7 @@ namespace platf {
       << "largeMotor: "sv << (int) largeMotor << std::endl
       << "smallMotor: "sv << (int) smallMotor;
 
-    task_pool.push(&vigem_t::rumble, (vigem_t *) userdata, target, largeMotor, smallMotor);
+    input_pool.push(&vigem_t::rumble, (vigem_t *) userdata, target, largeMotor, smallMotor);
   }
 
   void CALLBACK ds4_notify(
@@ -512,8 +512,8 @@ namespace platf {
       << util::hex(led_color.Green).to_string_view() << ' '
       << util::hex(led_color.Blue).to_string_view() << std::endl;
 
-    task_pool.push(&vigem_t::rumble, (vigem_t *) userdata, target, largeMotor, smallMotor);
-    task_pool.push(&vigem_t::set_rgb_led, (vigem_t *) userdata, target, led_color.Red, led_color.Green, led_color.Blue);
+    input_pool.push(&vigem_t::rumble, (vigem_t *) userdata, target, largeMotor, smallMotor);
+    input_pool.push(&vigem_t::set_rgb_led, (vigem_t *) userdata, target, led_color.Red, led_color.Green, led_color.Blue);
   }
 
   /**
@@ -924,7 +924,7 @@ namespace platf {
 
     // Cancel any pending updates. We will requeue one here when we're finished.
     if (gamepad.repeat_task) {
-      task_pool.cancel(gamepad.repeat_task);
+      input_pool.cancel(gamepad.repeat_task);
       gamepad.repeat_task = nullptr;
     }
 
@@ -944,7 +944,7 @@ namespace platf {
 
       // Repeat at least every 100ms to keep the 16-bit timestamp field from overflowing
       gamepad.last_report_ts = now;
-      gamepad.repeat_task = task_pool.pushDelayed(ds4_update_ts_and_send, 100ms, vigem, nr).task_id;
+      gamepad.repeat_task = input_pool.pushDelayed(ds4_update_ts_and_send, 100ms, vigem, nr).task_id;
     }
   }
 
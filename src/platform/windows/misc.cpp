@@ -1756,6 +1756,20 @@ namespace platf {
     return std::make_unique<qos_t>(flow_id);
   }
 
+  /**
+   * @brief Kernel pacing with SO_TXTIME is not available on this platform.
+   */
+  bool enable_socket_txtime(uintptr_t native_socket) {
+    return false;
+  }
+
+  /**
+   * @brief Kernel pacing with SO_TXTIME is not available on this platform.
+   */
+  bool interface_honors_txtime(const std::string_view &address) {
+    return false;
+  }
+
   /**
    * @brief Read the current Windows high-resolution performance counter.
    */
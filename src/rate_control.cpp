@@ -0,0 +1,155 @@
+/**
+ * @file src/rate_control.cpp
+ * @brief Definitions for controllers that adapt the stream to feedback from the network.
+ */
+// standard includes
+#include <algorithm>
+
+// local includes
+#include "rate_control.h"
+
+namespace rate_control {
+  fec_controller_t::fec_controller_t(const fec_params_t &params, int initial_percentage, clock::time_point now):
+      _params {params},
+      _percentage {std::clamp(initial_percentage, params.min_percentage, params.max_percentage)},
+      _last_change {now} {
+  }
+
+  int fec_controller_t::on_loss_report(std::uint64_t lost, std::uint64_t sent, clock::time_point now) {
+    if (lost == 0) {
+      // Lower the percentage one step for every quiet period without loss
+      if (now - _last_change >= _params.quiet_period) {
+        _percentage = std::max(_percentage - _params.step_down, _params.min_percentage);
+        _last_change = now;
+      }
+
+      return _percentage;
+    }
+
+    // Recovering a burst of loss takes about twice as many parity shards as were lost
+    auto target = _percentage + _params.step_up;
+    if (sent > 0) {
+      auto loss_percentage = (int) std::min<std::uint64_t>((lost * 200 + sent - 1) / sent, _params.max_percentage);
+      target = std::max(target, loss_percentage);
+    }
+
+    _percentage = std::clamp(target, _params.min_percentage, _params.max_percentage);
+    _last_change = now;
+
+    return _percentage;
+  }
+
+  bitrate_controller_t::bitrate_controller_t(const bitrate_params_t &params, clock::time_point now):
+      _params {params},
+      _target {params.max_kbps},
+      _last_change {now},
+      _last_congestion {now} {
+  }
+
+  bool bitrate_controller_t::congested(const bitrate_feedback_t &feedback) const {
+    if (feedback.lost > 0) {
+      // Without a packet count, any loss counts as congestion
+      if (feedback.sent == 0 || feedback.lost * 100 > feedback.sent * _params.loss_percentage) {
+        return true;
+      }
+    }
+
+    if (_params.max_send_latency > std::chrono::nanoseconds::zero() && feedback.send_latency > _params.max_send_latency) {
+      return true;
+    }
+
+    return feedback.queue_depth > _params.max_queue_depth;
+  }
+
+  int bitrate_controller_t::on_feedback(const bitrate_feedback_t &feedback, clock::time_point now) {
+    auto rate_limited = now - _last_change < _params.min_interval;
+
+    if (congested(feedback)) {
+      _last_congestion = now;
+
+      if (!rate_limited) {
+        auto target = std::max<int>((std::int64_t) _target * (100 - _params.decrease_percent) / 100, _params.min_kbps);
+        if (target != _target) {
+          _target = target;
+          _last_change = now;
+        }
+      }
+
+      return _target;
+    }
+
+    // Probe upwards again once the link has been quiet for a while
+    if (!rate_limited && _target < _params.max_kbps && now - _last_congestion >= _params.recovery_delay) {
+      auto step = std::max<int>((std::int64_t) _target * _params.increase_percent / 100, 1);
+      _target = std::min(_target + step, _params.max_kbps);
+      _last_change = now;
+    }
+
+    return _target;
+  }
+
+  audio_controller_t::audio_controller_t(const audio_params_t &params, clock::time_point now):
+      _params {params},
+      _last_loss {now},
+      _last_change {now} {
+  }
+
+  const audio_settings_t &audio_controller_t::on_loss_report(std::uint64_t lost, std::uint64_t sent, clock::time_point now) {
+    if (lost == 0) {
+      if (now - _last_loss < _params.quiet_period) {
+        return _settings;
+      }
+
+      // In-band FEC costs bits of every packet, so it goes away as soon as the link is quiet
+      _losing = false;
+      _settings.loss_percentage = 0;
+      _settings.inband_fec = false;
+
+      // The bitrate comes back more slowly, one step for every quiet period
+      if (_settings.bitrate_percentage < 100 && now - _last_change >= _params.quiet_period) {
+        _settings.bitrate_percentage = std::min(_settings.bitrate_percentage + _params.increase_step, 100);
+        _last_change = now;
+      }
+
+      return _settings;
+    }
+
+    if (!_losing) {
+      _losing = true;
+      _loss_start = now;
+    }
+    _last_loss = now;
+
+    // Without a packet count, prepare for the worst loss allowed
+    auto loss_percentage = _params.max_loss_percentage;
+    if (sent > 0) {
+      loss_percentage = (int) std::min<std::uint64_t>((lost * 100 + sent - 1) / sent, _params.max_loss_percentage);
+    }
+
+    // Hold the highest loss seen until the link is quiet again
+    _settings.inband_fec = true;
+    _settings.loss_percentage = std::clamp(std::max(_settings.loss_percentage, loss_percentage), 1, std::max(_params.max_loss_percentage, 1));
+
+    if (now - _loss_start >= _params.sustained_loss && now - _last_change >= _params.min_interval) {
+      auto bitrate_percentage = std::max(_settings.bitrate_percentage - _params.decrease_step, _params.min_bitrate_percentage);
+      if (bitrate_percentage != _settings.bitrate_percentage) {
+        _settings.bitrate_percentage = bitrate_percentage;
+        _last_change = now;
+      }
+    }
+
+    return _settings;
+  }
+
+  int max_fec_percentage(std::size_t data_shards, std::size_t max_blocks, int max_shards) {
+    if (data_shards == 0 || max_blocks == 0) {
+      return 0;
+    }
+
+    // Solve (max_shards * 100) / (100 + P) >= D for the largest P
+    auto data_shards_per_block = (data_shards + max_blocks - 1) / max_blocks;
+    auto percentage = (int) ((std::size_t) max_shards * 100 / data_shards_per_block) - 100;
+
+    return std::max(percentage, 0);
+  }
+}  // namespace rate_control
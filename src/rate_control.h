@@ -0,0 +1,239 @@
+/**
+ * @file src/rate_control.h
+ * @brief Declarations for controllers that adapt the stream to feedback from the network.
+ */
+#pragma once
+
+// standard includes
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace rate_control {
+  /**
+   * @brief Parameters of the adaptive FEC controller.
+   */
+  struct fec_params_t {
+    int min_percentage;  ///< Lowest FEC percentage the controller may choose.
+    int max_percentage;  ///< Highest FEC percentage the controller may choose.
+    int step_up = 10;  ///< Minimum increase of the percentage when loss is reported.
+    int step_down = 5;  ///< Decrease of the percentage after each quiet period.
+    std::chrono::milliseconds quiet_period = std::chrono::seconds {5};  ///< Time without loss before the percentage is lowered.
+  };
+
+  /**
+   * @brief Chooses the FEC percentage of a session from the loss reported by its client.
+   *
+   * Reported loss raises the percentage to at least twice the observed loss rate.
+   * Each quiet period without loss lowers it again by a small step.
+   */
+  class fec_controller_t {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    fec_controller_t() = default;
+
+    /**
+     * @brief Create a controller.
+     *
+     * @param params Bounds and steps of the controller.
+     * @param initial_percentage Percentage to start from, clamped to the bounds.
+     * @param now Current time.
+     */
+    fec_controller_t(const fec_params_t &params, int initial_percentage, clock::time_point now);
+
+    /**
+     * @brief Update the percentage from a client loss report.
+     *
+     * @param lost Packets the client lost since its last report.
+     * @param sent Packets sent to the client since its last report, or 0 if unknown.
+     * @param now Current time.
+     * @return The new FEC percentage.
+     */
+    int on_loss_report(std::uint64_t lost, std::uint64_t sent, clock::time_point now);
+
+    /**
+     * @brief Current FEC percentage.
+     *
+     * @return FEC percentage within the configured bounds.
+     */
+    int percentage() const {
+      return _percentage;
+    }
+
+  private:
+    fec_params_t _params {};
+    int _percentage = 0;
+    clock::time_point _last_change;
+  };
+
+  /**
+   * @brief Parameters of the adaptive bitrate controller.
+   */
+  struct bitrate_params_t {
+    int min_kbps;  ///< Lowest bitrate the controller may choose.
+    int max_kbps;  ///< Highest bitrate the controller may choose, usually the negotiated bitrate.
+    std::chrono::nanoseconds max_send_latency;  ///< Time a frame may spend in send calls before the link is considered saturated.
+    int max_queue_depth = 2;  ///< Frames that may wait for a sender before the link is considered saturated.
+    int loss_percentage = 2;  ///< Reported loss above this percentage of the sent packets is considered congestion.
+    int decrease_percent = 20;  ///< Part of the bitrate removed on congestion.
+    int increase_percent = 5;  ///< Part of the bitrate added back after each recovery step.
+    std::chrono::milliseconds min_interval = std::chrono::seconds {1};  ///< Minimum time between two bitrate changes.
+    std::chrono::milliseconds recovery_delay = std::chrono::seconds {5};  ///< Time without congestion before the bitrate is raised.
+  };
+
+  /**
+   * @brief Network feedback gathered for a session since the previous update.
+   */
+  struct bitrate_feedback_t {
+    std::uint64_t lost;  ///< Packets the client lost since its last report.
+    std::uint64_t sent;  ///< Packets sent to the client since its last report, or 0 if unknown.
+    std::chrono::nanoseconds send_latency;  ///< Longest time a single frame spent in send calls.
+    int queue_depth;  ///< Most frames seen waiting for the sender.
+  };
+
+  /**
+   * @brief Chooses the target video bitrate of a session from network feedback.
+   *
+   * Loss above the threshold, slow sends or a growing sender queue cut the bitrate
+   * multiplicatively. After a quiet period it is raised again in small steps up to
+   * the maximum. Changes are at least `min_interval` apart.
+   */
+  class bitrate_controller_t {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    bitrate_controller_t() = default;
+
+    /**
+     * @brief Create a controller that starts at the maximum bitrate.
+     *
+     * @param params Bounds and steps of the controller.
+     * @param now Current time.
+     */
+    bitrate_controller_t(const bitrate_params_t &params, clock::time_point now);
+
+    /**
+     * @brief Update the target bitrate from network feedback.
+     *
+     * @param feedback Feedback gathered since the previous update.
+     * @param now Current time.
+     * @return The new target bitrate in kilobits per second.
+     */
+    int on_feedback(const bitrate_feedback_t &feedback, clock::time_point now);
+
+    /**
+     * @brief Check whether feedback indicates a congested link.
+     *
+     * @param feedback Feedback gathered since the previous update.
+     * @return `true` if the bitrate should be lowered.
+     */
+    bool congested(const bitrate_feedback_t &feedback) const;
+
+    /**
+     * @brief Current target bitrate.
+     *
+     * @return Bitrate in kilobits per second within the configured bounds.
+     */
+    int target() const {
+      return _target;
+    }
+
+  private:
+    bitrate_params_t _params {};
+    int _target = 0;
+    clock::time_point _last_change;
+    clock::time_point _last_congestion;
+  };
+
+  /**
+   * @brief Parameters of the adaptive audio controller.
+   */
+  struct audio_params_t {
+    int min_bitrate_percentage = 50;  ///< Lowest bitrate the controller may choose, as a percentage of the configured bitrate.
+    int max_loss_percentage = 25;  ///< Highest expected loss passed to the encoder.
+    int decrease_step = 15;  ///< Percentage points of the bitrate removed under sustained loss.
+    int increase_step = 10;  ///< Percentage points of the bitrate added back after each quiet period.
+    std::chrono::milliseconds sustained_loss = std::chrono::seconds {2};  ///< Time loss must persist before the bitrate is lowered.
+    std::chrono::milliseconds min_interval = std::chrono::seconds {1};  ///< Minimum time between two bitrate decreases.
+    std::chrono::milliseconds quiet_period = std::chrono::seconds {5};  ///< Time without loss before the encoder starts returning to its configured settings.
+  };
+
+  /**
+   * @brief Opus encoder settings chosen for a session.
+   */
+  struct audio_settings_t {
+    int bitrate_percentage = 100;  ///< Bitrate as a percentage of the configured bitrate.
+    int loss_percentage = 0;  ///< Expected packet loss the encoder prepares for.
+    bool inband_fec = false;  ///< Whether the encoder adds in-band FEC to its packets.
+
+    bool operator==(const audio_settings_t &) const = default;
+  };
+
+  /**
+   * @brief Chooses the Opus encoder settings of a session from the loss reported by its client.
+   *
+   * Any loss enables in-band FEC and raises the expected loss to the observed loss rate.
+   * Loss that persists lowers the bitrate step by step, so the in-band FEC fits into the
+   * constant packet size. Once a quiet period passes without loss, in-band FEC is disabled
+   * again and each further quiet period raises the bitrate one step, up to the configured
+   * bitrate.
+   *
+   * Clients only report the loss of video packets, so the controller is fed the video loss
+   * rate as an estimate of the loss on the path both streams share.
+   */
+  class audio_controller_t {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    audio_controller_t() = default;
+
+    /**
+     * @brief Create a controller that starts at the configured settings.
+     *
+     * @param params Bounds and steps of the controller.
+     * @param now Current time.
+     */
+    audio_controller_t(const audio_params_t &params, clock::time_point now);
+
+    /**
+     * @brief Update the settings from a client loss report.
+     *
+     * @param lost Packets the client lost since its last report.
+     * @param sent Packets sent to the client since its last report, or 0 if unknown.
+     * @param now Current time.
+     * @return The new encoder settings.
+     */
+    const audio_settings_t &on_loss_report(std::uint64_t lost, std::uint64_t sent, clock::time_point now);
+
+    /**
+     * @brief Current encoder settings.
+     *
+     * @return Settings within the configured bounds.
+     */
+    const audio_settings_t &settings() const {
+      return _settings;
+    }
+
+  private:
+    audio_params_t _params {};
+    audio_settings_t _settings {};
+    bool _losing = false;
+    clock::time_point _loss_start;
+    clock::time_point _last_loss;
+    clock::time_point _last_change;
+  };
+
+  /**
+   * @brief Highest FEC percentage that still lets a frame fit into a number of FEC blocks.
+   *
+   * Data and parity shards of an FEC block share a limit of `max_shards`, so more parity
+   * leaves room for fewer data shards per block.
+   *
+   * @param data_shards Data shards of the frame.
+   * @param max_blocks FEC blocks available to the frame.
+   * @param max_shards Data and parity shards allowed in a single FEC block.
+   * @return Highest usable percentage, or 0 if the frame can't fit with any FEC.
+   */
+  int max_fec_percentage(std::size_t data_shards, std::size_t max_blocks, int max_shards);
+}  // namespace rate_control
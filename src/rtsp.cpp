@@ -26,6 +26,7 @@ extern "C" {
 #include "globals.h"
 #include "input.h"
 #include "logging.h"
+#include "mail.h"
 #include "network.h"
 #include "rtsp.h"
 #include "stream.h"
@@ -7,6 +7,8 @@
 #include <fstream>
 #include <future>
 #include <queue>
+#include <random>
+#include <span>
 
 // lib includes
 #include <boost/endian/arithmetic.hpp>
@@ -22,15 +24,21 @@ extern "C" {
 // local includes
 #include "config.h"
 #include "display_device.h"
+#include "gf256.h"
 #include "globals.h"
 #include "input.h"
 #include "logging.h"
+#include "mail.h"
 #include "network.h"
+#include "pacer.h"
+#include "packet_arena.h"
 #include "platform/common.h"
 #include "process.h"
+#include "rate_control.h"
 #include "stream.h"
 #include "sync.h"
 #include "system_tray.h"
+#include "thread_pool.h"
 #include "thread_safe.h"
 #include "utility.h"
 
@@ -313,6 +321,12 @@ namespace stream {
 
   constexpr std::size_t MAX_AUDIO_PACKET_SIZE = 1400;  ///< Protocol or platform constant for max audio packet size.
 
+  // There are 2 bits for FEC block count for a maximum of 4 FEC blocks
+  constexpr int MAX_FEC_BLOCKS = 4;  ///< Maximum number of FEC blocks in a video frame.
+  constexpr int MAX_FEC_THREADS = 4;  ///< Maximum number of threads preparing the FEC blocks of a video frame.
+  constexpr std::size_t MIN_SHARDS_PER_ENCRYPT_TASK = 16;  ///< Fewest shards worth handing to another thread for encryption.
+  constexpr std::int64_t FIXED_PACING_RATE_KBPS = 800'000;  ///< Video send rate when bitrate-aware pacing is disabled.
+
   /**
    * @brief AES key storage used for audio packet encryption.
    */
@@ -435,6 +449,15 @@ namespace stream {
       enet_host_flush(_host.get());
     }
 
+    /**
+     * @brief Time the message being handled came out of ENet.
+     *
+     * @return Receive time of the current message.
+     */
+    std::chrono::steady_clock::time_point received() const {
+      return _received;
+    }
+
     // Callbacks
     std::unordered_map<std::uint16_t, std::function<void(session_t *, const std::string_view &)>> _map_type_cb;  ///< Control-message handlers keyed by packet type.
 
@@ -446,6 +469,8 @@ namespace stream {
 
     ENetAddress _addr;  ///< Local ENet address used by the control channel.
     net::host_t _host;  ///< ENet host object that owns the control socket.
+
+    std::chrono::steady_clock::time_point _received;  ///< Receive time of the message being handled.
   };
 
   /**
@@ -456,12 +481,17 @@ namespace stream {
 
     std::jthread recv_thread;  ///< Thread that receives incoming control-channel messages.
     std::jthread video_thread;  ///< Thread that sends encoded video packets.
+
+    std::vector<std::shared_ptr<safe::queue_t<video::packet_t>>> video_shard_queues;  ///< Frame queues of the fixed video sender shards.
+    std::vector<std::jthread> video_shard_threads;  ///< Threads that send the frames of each video sender shard.
+    std::atomic_uint next_video_shard;  ///< Shard assigned to the next session, in round-robin order.
     std::jthread audio_thread;  ///< Thread that sends encoded audio packets.
     std::jthread control_thread;  ///< Thread that runs the ENet control server.
 
     asio::io_context io_context;  ///< Asio context used by the UDP broadcast sockets.
 
     udp::socket video_sock {io_context};  ///< UDP socket bound for video packet transmission.
+    bool video_txtime;  ///< True when the kernel paces video packets by their launch time.
     udp::socket audio_sock {io_context};  ///< UDP socket bound for audio packet transmission.
 
     control_server_t control_server;  ///< ENet server for GameStream control packets.
@@ -492,12 +522,44 @@ namespace stream {
       int lowseq;
       udp::endpoint peer;
 
-      std::optional<crypto::cipher::gcm_t> cipher;
+      // Sender queue for this session's frames when video senders are sharded
+      std::shared_ptr<safe::queue_t<video::packet_t>> send_queue;
+
+      // Empty unless video is encrypted. With fec_threads > 1, the first FEC block of a frame is split
+      // across fec_threads ciphers and the other blocks get one each, so no cipher context is ever
+      // shared between threads. Otherwise a single cipher encrypts every block in turn.
+      std::vector<crypto::cipher::gcm_t> ciphers;
       std::uint64_t gcm_iv_counter;
 
+      // Only touched by the thread that sends this session's frames
+      pacer::token_bucket_t pacer;
+      bool txtime;  // The kernel sends this session's packets at their launch time
+
+#ifdef SUNSHINE_TESTS
+      // Counters filled by the sender after each frame of this session, set by testing::replay_video()
+      testing::video_send_stats_t *send_stats = nullptr;
+#endif
+
+      // FEC percentage chosen from the client's loss reports on the control thread
+      std::atomic_int fec_percentage;
+      std::atomic_uint64_t packets_sent;
+      rate_control::fec_controller_t fec_controller;
+      std::uint64_t packets_sent_at_loss_report;
+
+      // Target bitrate chosen on the control thread from loss reports and the sender's congestion
+      // signals below, which the sender raises and the control thread resets with each report
+      std::atomic_int target_bitrate;
+      std::atomic<std::int64_t> max_send_latency_ns;
+      std::atomic_int max_queue_depth;
+      rate_control::bitrate_controller_t bitrate_controller;
+      safe::mail_raw_t::event_t<int> bitrate_events;
+
       safe::mail_raw_t::event_t<bool> idr_events;
       safe::mail_raw_t::event_t<std::pair<int64_t, int64_t>> invalidate_ref_frames_events;
 
+      // Time from capture to the end of sending of the last captured frame, or -1 before the first one
+      std::atomic<std::int64_t> frame_latency_ns;
+
       std::unique_ptr<platf::deinit_t> qos;
     } video;  ///< Video worker thread state for the active stream.
 
@@ -515,6 +577,11 @@ namespace stream {
       util::buffer_t<uint8_t *> shards_p;
 
       audio_fec_packet_t fec_packet;
+
+      // Opus settings chosen on the control thread from the client's loss reports
+      rate_control::audio_controller_t controller;
+      safe::mail_raw_t::event_t<rate_control::audio_settings_t> settings_events;
+
       std::unique_ptr<platf::deinit_t> qos;
     } audio;  ///< Audio capture configuration for the stream..
 
@@ -721,7 +788,8 @@ namespace stream {
         return;
       }
 
-      session->pingTimeout = std::chrono::steady_clock::now() + config::stream.ping_timeout;
+      _received = std::chrono::steady_clock::now();
+      session->pingTimeout = _received + config::stream.ping_timeout;
 
       switch (event.type) {
         case ENET_EVENT_TYPE_RECEIVE:
@@ -758,22 +826,102 @@ namespace stream {
       reed_solomon_release(rs);
     }>;
 
+    /**
+     * @brief Reed-Solomon encoders reused across FEC blocks, keyed by shard counts.
+     *
+     * Creating an encoder rebuilds its GF(256) parity matrix, which is far more
+     * expensive than encoding a single block. Each sender thread owns one cache.
+     * Encoders stay valid until the cache is trimmed, which the sender only does
+     * between frames, so the blocks of a frame can be encoded on other threads.
+     */
+    class rs_cache_t {
+    public:
+      /**
+       * @brief Upper bound on cached encoders before the cache is flushed.
+       */
+      static constexpr std::size_t MAX_ENCODERS = 256;
+
+      /**
+       * @brief Return the encoder for the given shard counts, creating it on a miss.
+       *
+       * @param data_shards Number of data shards in the FEC block.
+       * @param parity_shards Number of parity shards in the FEC block.
+       * @return Encoder owned by the cache, or nullptr if one could not be created.
+       */
+      reed_solomon *get(std::size_t data_shards, std::size_t parity_shards) {
+        auto key = std::make_pair(data_shards, parity_shards);
+
+        auto it = _encoders.find(key);
+        if (it != std::end(_encoders)) {
+          ++hits;
+          return it->second.get();
+        }
+
+        ++misses;
+
+        rs_t rs {reed_solomon_new((int) data_shards, (int) parity_shards)};
+        if (!rs) {
+          return nullptr;
+        }
+
+        return _encoders.emplace(key, std::move(rs)).first->second.get();
+      }
+
+      /**
+       * @brief Flush the cache if it holds more than MAX_ENCODERS, invalidating all returned encoders.
+       */
+      void trim() {
+        // Frame sizes vary wildly, so don't let the cache grow without bound
+        if (_encoders.size() > MAX_ENCODERS) {
+          _encoders.clear();
+        }
+      }
+
+      std::uint64_t hits = 0;  ///< Lookups served by an existing encoder.
+      std::uint64_t misses = 0;  ///< Lookups that had to create a new encoder.
+
+    private:
+      std::map<std::pair<std::size_t, std::size_t>, rs_t> _encoders;
+    };
+
     /**
      * @brief Reed-Solomon FEC encoder state for video packets.
+     *
+     * Each shard is sent as a fixed-size header followed by a fixed-size payload.
+     * Headers live in their own array and payloads point into the caller's buffer
+     * wherever possible, so the frame is never copied just to make room for headers.
+     * Parity is computed over the header and payload columns separately, which
+     * yields the same bytes as encoding contiguous header+payload shards.
+     *
+     * Storage comes from the sender's packet arena and is given back by clear(),
+     * so a block can be laid out again for the next frame without allocating.
      */
     struct fec_t {
-      size_t data_shards;  ///< Number of original packet shards in each FEC block.
-      size_t nr_shards;  ///< Total data and recovery shards generated for each FEC block.
-      size_t percentage;  ///< Recovery-shard percentage requested for the stream.
+      size_t data_shards = 0;  ///< Number of original packet shards in each FEC block.
+      size_t nr_shards = 0;  ///< Total data and recovery shards generated for each FEC block.
+      size_t percentage = 0;  ///< Recovery-shard percentage requested for the stream.
 
-      size_t blocksize;  ///< Bytes reserved for the payload portion of each shard.
-      size_t prefixsize;  ///< Bytes reserved before each shard payload for protocol headers.
-      util::buffer_t<char> shards;  ///< Contiguous backing storage for all encoded FEC shards.
-      util::buffer_t<char> headers;  ///< Backing storage for the RTP/FEC headers attached to shards.
-      util::buffer_t<uint8_t *> shards_p;  ///< Pointer table passed to the Reed-Solomon encoder.
+      size_t blocksize = 0;  ///< Bytes reserved for the payload portion of each shard.
+      size_t prefixsize = 0;  ///< Bytes reserved before each shard payload for protocol headers.
+      packet_arena::buffer_t<char> shards;  ///< Backing storage for copied, zero-padded and parity shard payloads.
+      packet_arena::buffer_t<char> headers;  ///< Backing storage for the RTP/FEC headers attached to shards.
+      packet_arena::buffer_t<uint8_t *> shards_p;  ///< Pointer table passed to the Reed-Solomon encoder.
+      packet_arena::buffer_t<uint8_t *> headers_p;  ///< Pointer table of the headers passed to the Reed-Solomon encoder.
 
       std::vector<platf::buffer_descriptor_t> payload_buffers;  ///< Platform send descriptors for FEC payload buffers.
 
+      /**
+       * @brief Give the storage back to the arena, keeping the descriptor capacity.
+       */
+      void clear() {
+        data_shards = nr_shards = 0;
+        shards = {};
+        headers = {};
+        shards_p = {};
+        headers_p = {};
+        payload_buffers.clear();
+      }
+
       /**
        * @brief Return the FEC shard data pointer for a packet-group element.
        *
@@ -804,13 +952,27 @@ namespace stream {
       }
     };
 
-    static fec_t encode(const std::string_view &payload, size_t blocksize, size_t fecpercentage, size_t minparityshards, size_t prefixsize) {
-      auto payload_size = payload.size();
-
-      auto pad = payload_size % blocksize != 0;
+    /**
+     * @brief Lay out one FEC block as data shards without copying the payload.
+     *
+     * The block's data is `head` followed by `payload`, cut into `blocksize` shards.
+     * Shards that lie entirely inside `payload` point straight into it; only shards
+     * that straddle `head` or need zero padding are copied. Headers are zeroed and
+     * must be filled in for the data shards before calling encode().
+     *
+     * @param fec Block to lay out, its previous storage must have been cleared.
+     * @param arena Arena the storage is borrowed from.
+     * @param head Bytes that precede the payload in the first shard (may be empty).
+     * @param payload Payload bytes; must outlive the returned object.
+     * @param blocksize Payload bytes per shard.
+     * @param prefixsize Header bytes per shard that are protected by FEC.
+     * @param fecpercentage Requested parity percentage.
+     * @param minparityshards Minimum number of parity shards when FEC is enabled.
+     */
+    static void split(fec_t &fec, packet_arena::arena_t &arena, const std::string_view &head, const std::string_view &payload, size_t blocksize, size_t prefixsize, size_t fecpercentage, size_t minparityshards) {
+      auto data_size = head.size() + payload.size();
 
-      auto aligned_data_shards = payload_size / blocksize;
-      auto data_shards = aligned_data_shards + (pad ? 1 : 0);
+      auto data_shards = (data_size + (blocksize - 1)) / blocksize;
       auto parity_shards = (data_shards * fecpercentage + 99) / 100;
 
       // increase the FEC percentage for this frame if the parity shard minimum is not met
@@ -823,63 +985,103 @@ namespace stream {
 
       auto nr_shards = data_shards + parity_shards;
 
-      // If we need to store a zero-padded data shard, allocate that first to
-      // to keep the shards in order and reduce buffer fragmentation
-      auto parity_shard_offset = pad ? 1 : 0;
-      util::buffer_t<char> shards {(parity_shard_offset + parity_shards) * blocksize};
-      util::buffer_t<uint8_t *> shards_p {nr_shards};
-      std::vector<platf::buffer_descriptor_t> payload_buffers;
-      payload_buffers.reserve(2);
-
-      // Point into the payload buffer for all except the final padded data shard
-      auto next = std::begin(payload);
-      for (auto x = 0; x < aligned_data_shards; ++x) {
-        shards_p[x] = (uint8_t *) next;
-        next += blocksize;
-      }
-      payload_buffers.emplace_back(std::begin(payload), aligned_data_shards * blocksize);
-
-      // If the last data shard needs to be zero-padded, we must use the shards buffer
-      if (pad) {
-        shards_p[aligned_data_shards] = (uint8_t *) &shards[0];
-
-        // GCC doesn't figure out that std::copy_n() can be replaced with memcpy() here
-        // and ends up compiling a horribly slow element-by-element copy loop, so we
-        // help it by using memcpy()/memset() directly.
-        auto copy_len = std::min<size_t>(blocksize, std::end(payload) - next);
-        std::memcpy(shards_p[aligned_data_shards], next, copy_len);
-        if (copy_len < blocksize) {
-          // Zero any additional space after the end of the payload
-          std::memset(shards_p[aligned_data_shards] + copy_len, 0, blocksize - copy_len);
-        }
+      // A data shard can point into the payload if it doesn't overlap the head or run past the end
+      auto is_direct = [&](size_t x) {
+        return x * blocksize >= head.size() && (x + 1) * blocksize <= data_size;
+      };
+
+      auto copied_shards = parity_shards;
+      for (auto x = 0; x < data_shards; ++x) {
+        copied_shards += is_direct(x) ? 0 : 1;
       }
 
-      // Add a payload buffer describing the shard buffer
-      payload_buffers.emplace_back(std::begin(shards), shards.size());
+      packet_arena::buffer_t<char> shards {arena, copied_shards * blocksize};
+      packet_arena::buffer_t<uint8_t *> shards_p {arena, nr_shards};
+      auto &payload_buffers = fec.payload_buffers;
+      payload_buffers.reserve(3);
 
-      if (fecpercentage != 0) {
-        // Point into our allocated buffer for the parity shards
-        for (auto x = 0; x < parity_shards; ++x) {
-          shards_p[data_shards + x] = (uint8_t *) &shards[(parity_shard_offset + x) * blocksize];
+      auto next_copy = std::begin(shards);
+      for (auto x = 0; x < nr_shards; ++x) {
+        if (x < data_shards && is_direct(x)) {
+          shards_p[x] = (uint8_t *) &payload[x * blocksize - head.size()];
+        } else {
+          shards_p[x] = (uint8_t *) next_copy;
+          next_copy += blocksize;
         }
 
-        // packets = parity_shards + data_shards
-        rs_t rs {reed_solomon_new((int) data_shards, (int) parity_shards)};
+        // Data shards that aren't in the payload buffer are gathered from the head and payload,
+        // and zero-padded at the end. Parity shards are overwritten by the encoder.
+        if (x < data_shards && !is_direct(x)) {
+          auto begin = x * blocksize;
+          auto end = std::min(begin + blocksize, data_size);
+          auto *dst = shards_p[x];
+
+          // GCC doesn't figure out that std::copy_n() can be replaced with memcpy() here
+          // and ends up compiling a horribly slow element-by-element copy loop, so we
+          // help it by using memcpy()/memset() directly.
+          if (begin < head.size()) {
+            auto copy_len = std::min(end, head.size()) - begin;
+            std::memcpy(dst, head.data() + begin, copy_len);
+            dst += copy_len;
+            begin += copy_len;
+          }
+          if (begin < end) {
+            std::memcpy(dst, payload.data() + (begin - head.size()), end - begin);
+            dst += end - begin;
+          }
+          std::memset(dst, 0, shards_p[x] + blocksize - dst);
+        }
 
-        reed_solomon_encode(rs.get(), shards_p.begin(), (int) nr_shards, (int) blocksize);
+        // Merge shards that are adjacent in memory into a single payload buffer
+        auto *shard = (const char *) shards_p[x];
+        if (!payload_buffers.empty() && payload_buffers.back().buffer + payload_buffers.back().size == shard) {
+          payload_buffers.back().size += blocksize;
+        } else {
+          payload_buffers.emplace_back(shard, blocksize);
+        }
       }
 
-      return {
-        data_shards,
-        nr_shards,
-        fecpercentage,
-        blocksize,
-        prefixsize,
-        std::move(shards),
-        util::buffer_t<char> {nr_shards * prefixsize},
-        std::move(shards_p),
-        std::move(payload_buffers),
-      };
+      packet_arena::buffer_t<char> headers {arena, nr_shards * prefixsize};
+      std::memset(std::begin(headers), 0, headers.size());
+
+      packet_arena::buffer_t<uint8_t *> headers_p {arena, prefixsize ? nr_shards : 0};
+      for (auto x = 0; x < headers_p.size(); ++x) {
+        headers_p[x] = (uint8_t *) &headers[x * prefixsize];
+      }
+
+      fec.data_shards = data_shards;
+      fec.nr_shards = nr_shards;
+      fec.percentage = fecpercentage;
+      fec.blocksize = blocksize;
+      fec.prefixsize = prefixsize;
+      fec.shards = std::move(shards);
+      fec.headers = std::move(headers);
+      fec.shards_p = std::move(shards_p);
+      fec.headers_p = std::move(headers_p);
+    }
+
+    /**
+     * @brief Compute the parity shards of a block laid out by split().
+     *
+     * @param rs Encoder for the block's shard counts, or nullptr when FEC is disabled.
+     * @param fec FEC block whose data shard payloads and headers are final.
+     */
+    static void encode(reed_solomon *rs, fec_t &fec) {
+      if (fec.percentage == 0 || !rs) {
+        return;
+      }
+
+      // packets = parity_shards + data_shards
+      auto data_shards = fec.data_shards;
+      auto parity_shards = fec.nr_shards - fec.data_shards;
+
+      // Reed-Solomon operates on each byte column independently, so the header and
+      // payload columns of each shard can be encoded as two separate shard sets.
+      gf256::encode(rs->p, (int) data_shards, (int) parity_shards, fec.shards_p.begin(), fec.blocksize);
+
+      if (fec.prefixsize) {
+        gf256::encode(rs->p, (int) data_shards, (int) parity_shards, fec.headers_p.begin(), fec.prefixsize);
+      }
     }
   }  // namespace fec
 
@@ -955,6 +1157,48 @@ namespace stream {
     return replaced;
   }
 
+  /**
+   * @brief Replace a byte sequence at the start of an encoded packet without copying the rest.
+   *
+   * The packet is kept as a rewritten head followed by the untouched tail of the encoded
+   * buffer. The head grows up to the end of the replaced sequence, so rewriting the parameter
+   * sets at the start of an IDR frame only copies those few bytes. The head followed by the
+   * tail is always identical to what replace() returns for the whole packet.
+   *
+   * @param head Rewritten start of the packet, updated in place.
+   * @param tail Rest of the packet, advanced past any bytes moved into the head.
+   * @param old Byte sequence to replace in encoded packets.
+   * @param _new Replacement byte sequence inserted into encoded packets.
+   */
+  void replace_head(std::vector<uint8_t> &head, std::string_view &tail, const std::string_view &old, const std::string_view &_new) {
+    // Match entirely inside the head
+    auto next = std::search(std::begin(head), std::end(head), std::begin(old), std::end(old));
+    if (next != std::end(head) || old.empty()) {
+      head.insert(head.erase(next, next + old.size()), std::begin(_new), std::end(_new));
+      return;
+    }
+
+    // Match that starts in the head and ends in the tail
+    auto first = head.size() - std::min(head.size(), old.size() - 1);
+    for (auto x = first; x < head.size(); ++x) {
+      auto in_head = head.size() - x;
+      if (std::equal(std::begin(head) + x, std::end(head), std::begin(old)) && tail.starts_with(old.substr(in_head))) {
+        head.resize(x);
+        head.insert(std::end(head), std::begin(_new), std::end(_new));
+        tail.remove_prefix(old.size() - in_head);
+        return;
+      }
+    }
+
+    // Match inside the tail, everything before it moves into the head
+    auto pos = tail.find(old);
+    if (pos != std::string_view::npos) {
+      head.insert(std::end(head), std::begin(tail), std::begin(tail) + pos);
+      head.insert(std::end(head), std::begin(_new), std::end(_new));
+      tail.remove_prefix(pos + old.size());
+    }
+  }
+
   /**
    * @brief Pass gamepad feedback data back to the client.
    * @param session The session object.
@@ -1134,6 +1378,55 @@ namespace stream {
         << "time in milli since last report [" << t.count() << ']' << std::endl
         << "last good frame [" << lastGoodFrame << ']' << std::endl
         << "---end stats---";
+
+      auto now = std::chrono::steady_clock::now();
+      auto packets_sent = session->video.packets_sent.load();
+      auto packets_sent_since_report = packets_sent - session->video.packets_sent_at_loss_report;
+      session->video.packets_sent_at_loss_report = packets_sent;
+
+      if (config::stream.fec_adaptive) {
+        auto previous = session->video.fec_controller.percentage();
+        auto percentage = session->video.fec_controller.on_loss_report(std::max(count, 0), packets_sent_since_report, now);
+
+        if (percentage != previous) {
+          BOOST_LOG(debug) << "Adaptive FEC: "sv << previous << "% -> "sv << percentage << '%';
+          session->video.fec_percentage = percentage;
+        }
+      }
+
+      if (config::stream.video_adaptive_bitrate) {
+        rate_control::bitrate_feedback_t feedback {
+          (std::uint64_t) std::max(count, 0),
+          packets_sent_since_report,
+          std::chrono::nanoseconds {session->video.max_send_latency_ns.exchange(0)},
+          session->video.max_queue_depth.exchange(0),
+        };
+
+        auto previous = session->video.bitrate_controller.target();
+        auto bitrate = session->video.bitrate_controller.on_feedback(feedback, now);
+
+        if (bitrate != previous) {
+          BOOST_LOG(info) << "Adaptive bitrate: "sv << previous << " -> "sv << bitrate << " kbps (loss "sv
+                          << feedback.lost << '/' << feedback.sent << ", send latency "sv
+                          << std::chrono::duration<double, std::milli>(feedback.send_latency).count() << "ms, queue depth "sv
+                          << feedback.queue_depth << ')';
+          session->video.target_bitrate = bitrate;
+          session->video.bitrate_events->raise(bitrate);
+        }
+      }
+
+      // Clients don't report audio loss, the video loss rate stands in for the shared path
+      if (config::stream.audio_adaptive) {
+        auto previous = session->audio.controller.settings();
+        auto &settings = session->audio.controller.on_loss_report(std::max(count, 0), packets_sent_since_report, now);
+
+        if (settings != previous) {
+          BOOST_LOG(debug) << "Adaptive audio: "sv << settings.bitrate_percentage << "% bitrate, "sv
+                           << settings.loss_percentage << "% expected loss, in-band FEC "sv
+                           << (settings.inband_fec ? "on"sv : "off"sv);
+          session->audio.settings_events->raise(settings);
+        }
+      }
     });
 
     server->map(packetTypes[IDX_REQUEST_IDR_FRAME], [&](session_t *session, const std::string_view &payload) {
@@ -1178,7 +1471,7 @@ namespace stream {
         std::copy(payload.end() - 16, payload.end(), std::begin(iv));
       }
 
-      input::passthrough(session->input, std::move(plaintext));
+      input::passthrough(session->input, plaintext, server->received());
     });
 
     server->map(packetTypes[IDX_ENCRYPTED], [server](session_t *session, const std::string_view &payload) {
@@ -1240,8 +1533,7 @@ namespace stream {
 
       // IDX_INPUT_DATA callback will attempt to decrypt unencrypted data, therefore we need pass it directly
       if (type == packetTypes[IDX_INPUT_DATA]) {
-        plaintext.erase(std::begin(plaintext), std::begin(plaintext) + 4);
-        input::passthrough(session->input, std::move(plaintext));
+        input::passthrough(session->input, std::span {plaintext}.subspan(4), server->received());
       } else {
         server->call(type, session, next_payload, true);
       }
@@ -1462,17 +1754,188 @@ namespace stream {
   }
 
   /**
-   * @brief Run the broadcast video sender thread.
+   * @brief One FEC block of a video frame along with what is needed to finish and send it.
+   */
+  struct video_fec_block_t {
+    /**
+     * @brief Check whether the shards of this block are encrypted before sending.
+     *
+     * @return True when video encryption is enabled.
+     */
+    bool encrypted() const {
+      return !ciphers.empty();
+    }
+
+    fec::fec_t shards;  ///< Shard layout, packet headers and parity of the block.
+    reed_solomon *rs = nullptr;  ///< Encoder for the block's shard counts, or nullptr when FEC is disabled.
+    int lowseq = 0;  ///< RTP sequence number of the first shard.
+
+    std::span<crypto::cipher::gcm_t> ciphers;  ///< Ciphers that may encrypt this block concurrently, empty when encryption is disabled.
+    std::uint64_t gcm_iv_counter = 0;  ///< IV counter of the first shard.
+    packet_arena::buffer_t<char> enc_prefixes;  ///< Encryption prefixes sent before each encrypted shard.
+    packet_arena::buffer_t<char> ciphertext;  ///< Encrypted header+payload shards.
+    std::vector<platf::buffer_descriptor_t> ciphertext_buffers;  ///< Send descriptor for the ciphertext.
+
+    std::chrono::steady_clock::time_point fec_start;  ///< When parity computation started.
+    std::chrono::steady_clock::time_point fec_end;  ///< When parity computation finished.
+    std::chrono::steady_clock::time_point encrypt_end;  ///< When encryption finished, or fec_end when not encrypting.
+
+    /**
+     * @brief Give the buffers of the previous frame back to the arena, so the block can be reused.
+     */
+    void clear() {
+      shards.clear();
+      rs = nullptr;
+      lowseq = 0;
+      ciphers = {};
+      gcm_iv_counter = 0;
+      enc_prefixes = {};
+      ciphertext = {};
+      ciphertext_buffers.clear();
+    }
+
+    /**
+     * @brief Return the bytes sent before the payload of a shard.
+     *
+     * @param x Shard index.
+     * @return Encryption prefix when encrypting, otherwise the packet header.
+     */
+    char *send_header(std::size_t x) {
+      return encrypted() ? &enc_prefixes[x * sizeof(video_packet_enc_prefix_t)] : shards.prefix(x);
+    }
+
+    /**
+     * @brief Return the payload bytes sent for a shard.
+     *
+     * @param x Shard index.
+     * @return Encrypted header+payload when encrypting, otherwise the payload.
+     */
+    char *send_payload(std::size_t x) {
+      return encrypted() ? &ciphertext[x * send_payload_size()] : shards.data(x);
+    }
+
+    /**
+     * @brief Return the size of each send_header().
+     *
+     * @return Header size in bytes.
+     */
+    std::size_t send_header_size() const {
+      return encrypted() ? sizeof(video_packet_enc_prefix_t) : shards.prefixsize;
+    }
+
+    /**
+     * @brief Return the size of each send_payload().
+     *
+     * @return Payload size in bytes.
+     */
+    std::size_t send_payload_size() const {
+      return encrypted() ? shards.prefixsize + shards.blocksize : shards.blocksize;
+    }
+
+    /**
+     * @brief Return the payload buffers to hand to platf::send_batch().
+     *
+     * @return Payload buffer descriptors.
+     */
+    std::vector<platf::buffer_descriptor_t> &send_buffers() {
+      return encrypted() ? ciphertext_buffers : shards.payload_buffers;
+    }
+  };
+
+  /**
+   * @brief Encrypt a range of shards of a video FEC block.
+   *
+   * The cipher context is reused for every shard, only its IV changes.
+   *
+   * @param block Block whose headers and parity are final.
+   * @param cipher Cipher used by this thread.
+   * @param frame_index Frame number written to each encryption prefix.
+   * @param begin Index of the first shard to encrypt.
+   * @param end Index of the first shard to leave unencrypted.
+   */
+  static void encrypt_video_shards(video_fec_block_t &block, crypto::cipher::gcm_t &cipher, std::uint32_t frame_index, std::size_t begin, std::size_t end) {
+    crypto::aes_t iv(12);
+
+    for (auto x = begin; x < end; ++x) {
+      // We use the deterministic IV construction algorithm specified in NIST SP 800-38D
+      // Section 8.2.1. The sequence number is our "invocation" field and the 'V' in the
+      // high bytes is the "fixed" field. Because each client provides their own unique
+      // key, our values in the fixed field need only uniquely identify each independent
+      // use of the client's key with AES-GCM in our code.
+      //
+      // The IV counter is 64 bits long which allows for 2^64 encrypted video packets
+      // to be sent to each client before the IV repeats.
+      auto iv_counter = block.gcm_iv_counter + x;
+      std::copy_n((uint8_t *) &iv_counter, sizeof(iv_counter), std::begin(iv));
+      iv[11] = 'V';  // Video stream
+
+      // Encrypt the header and payload as one message into the ciphertext buffer
+      auto *prefix = (video_packet_enc_prefix_t *) block.send_header(x);
+      prefix->frameNumber = frame_index;
+      std::copy(std::begin(iv), std::end(iv), prefix->iv);
+
+      std::array<std::string_view, 2> plaintext {
+        std::string_view {block.shards.prefix(x), block.shards.prefixsize},
+        std::string_view {block.shards.data(x), block.shards.blocksize},
+      };
+      cipher.encrypt(plaintext, prefix->tag, (uint8_t *) block.send_payload(x), &iv);
+    }
+  }
+
+  /**
+   * @brief Encrypt every shard of a video FEC block in one pass, before any of it is sent.
+   *
+   * Large blocks are split into one range per cipher of the block. The calling thread
+   * encrypts the first range while the pool encrypts the others.
+   *
+   * @param block Block whose headers and parity are final.
+   * @param frame_index Frame number written to each encryption prefix.
+   * @param pool Workers for the ranges after the first.
+   */
+  static void encrypt_video_block(video_fec_block_t &block, std::uint32_t frame_index, thread_pool_util::ThreadPool &pool) {
+    auto shards = (std::size_t) block.shards.size();
+    auto ranges = std::clamp<std::size_t>(shards / MIN_SHARDS_PER_ENCRYPT_TASK, 1, block.ciphers.size());
+    auto range_size = (shards + ranges - 1) / ranges;
+
+    std::array<std::future<void>, MAX_FEC_THREADS> encrypted;
+
+    // Workers reference the block, so never leave before they are done with it
+    auto wait_for_workers = util::fail_guard([&]() {
+      for (auto &future : encrypted) {
+        if (future.valid()) {
+          future.wait();
+        }
+      }
+    });
+
+    for (std::size_t range = 1; range < ranges; ++range) {
+      auto begin = range * range_size;
+      auto end = std::min(begin + range_size, shards);
+      encrypted[range] = pool.push([&block, &cipher = block.ciphers[range], frame_index, begin, end]() {
+        encrypt_video_shards(block, cipher, frame_index, begin, end);
+      });
+    }
+
+    encrypt_video_shards(block, block.ciphers[0], frame_index, 0, std::min(range_size, shards));
+
+    for (std::size_t range = 1; range < ranges; ++range) {
+      // Rethrows any exception from the worker
+      encrypted[range].get();
+    }
+  }
+
+  /**
+   * @brief Packetize and send the video frames popped from a queue until it is stopped.
+   *
+   * Each caller gets its own loggers and FEC encoder cache. Pacing state belongs to each session.
    *
    * @param sock Socket used to read or write the protocol message.
+   * @param packets Queue of encoded frames to send.
    */
-  void videoBroadcastThread(udp::socket &sock) {
+  static void videoSendLoop(udp::socket &sock, safe::queue_t<video::packet_t> &packets) {
     auto shutdown_event = mail::man->event<bool>(mail::broadcast_shutdown);
-    auto packets = mail::man->queue<video::packet_t>(mail::video_packets);
     auto video_epoch = std::chrono::steady_clock::now();
 
-    // Video traffic is sent on this thread
-    platf::set_thread_name("stream::videoBroadcast");
     platf::adjust_thread_priority(platf::thread_priority_e::high);
 
     logging::min_max_avg_periodic_logger<double> frame_processing_latency_logger(debug, "Frame processing latency", "ms");
@@ -1480,8 +1943,28 @@ namespace stream {
     logging::time_delta_periodic_logger frame_send_batch_latency_logger(debug, "Network: each send_batch() latency");
     logging::time_delta_periodic_logger frame_fec_latency_logger(debug, "Network: each FEC block latency");
     logging::time_delta_periodic_logger frame_network_latency_logger(debug, "Network: frame's overall network latency");
-
-    crypto::aes_t iv(12);
+    logging::min_max_avg_periodic_logger<double> frame_fec_cache_hit_logger(debug, "Network: FEC encoder cache hit rate", "%");
+    logging::min_max_avg_periodic_logger<double> frame_pacing_delay_logger(debug, "Network: pacing delay per frame", "ms");
+    logging::min_max_avg_periodic_logger<double> frame_pacing_rate_logger(debug, "Network: pacing rate", "Mbps");
+    logging::min_max_avg_periodic_logger<double> frame_allocations_logger(debug, "Network: packet buffer allocations per frame", "");
+
+    // Reed-Solomon encoders are reused across frames and sessions served by this thread
+    fec::rs_cache_t rs_cache;
+
+    // Pacing waits of every session served by this thread
+    pacer::stats_t pacing_stats {};
+
+    // Shard, header and ciphertext buffers are recycled across frames and sessions served by
+    // this thread. The blocks keep their descriptor vectors from one frame to the next.
+    packet_arena::arena_t arena;
+    std::array<video_fec_block_t, MAX_FEC_BLOCKS> blocks;
+
+    // FEC blocks after the first may be encoded and encrypted on worker threads
+    // while this thread prepares and sends the first block of the frame
+    thread_pool_util::ThreadPool fec_pool;
+    if (config::stream.fec_threads > 1) {
+      fec_pool.start(config::stream.fec_threads - 1);
+    }
 
     auto timer = platf::create_high_precision_timer();
     if (!timer || !*timer) {
@@ -1489,32 +1972,36 @@ namespace stream {
       return;
     }
 
-    auto ratecontrol_next_frame_start = std::chrono::steady_clock::now();
-
-    while (auto packet = packets->pop()) {
+    while (auto packet = packets.pop()) {
       if (shutdown_event->peek()) {
         break;
       }
 
       frame_network_latency_logger.first_point_now();
+#ifdef SUNSHINE_TESTS
+      auto frame_start = std::chrono::steady_clock::now();
+#endif
 
       auto session = (session_t *) packet->channel_data;
       auto lowseq = session->video.lowseq;
 
+      // Frames of this session still waiting behind this one, a sign that sending can't keep up
+      // with its encoder. Other sessions may share the queue, their frames don't count.
+      auto queue_depth = (int) packets.count_if([session](const video::packet_t &queued) {
+        return queued->channel_data == session;
+      });
+
       std::string_view payload {(char *) packet->data(), packet->data_size()};
-      std::vector<uint8_t> payload_with_replacements;
+      std::vector<uint8_t> payload_head;
 
       // Apply replacements on the packet payload before performing any other operations.
       // We need to know the final frame size to calculate the last packet size, and we
       // must avoid matching replacements against the frame header or any other non-video
-      // part of the payload.
+      // part of the payload. Only the rewritten start of the frame is copied into
+      // payload_head, the rest is still sent straight from the encoder's buffer.
       if (packet->is_idr() && packet->replacements) {
         for (auto &replacement : *packet->replacements) {
-          auto frame_old = replacement.old;
-          auto frame_new = replacement._new;
-
-          payload_with_replacements = replace(payload, frame_old, frame_new);
-          payload = {(char *) payload_with_replacements.data(), payload_with_replacements.size()};
+          replace_head(payload_head, payload, replacement.old, replacement._new);
         }
       }
 
@@ -1523,7 +2010,7 @@ namespace stream {
       frame_header.frameType = packet->is_idr()                     ? 2 :
                                packet->after_ref_frame_invalidation ? 5 :
                                                                       1;
-      frame_header.lastPayloadLen = (payload.size() + sizeof(frame_header)) % (session->config.packetsize - sizeof(NV_VIDEO_PACKET));
+      frame_header.lastPayloadLen = (payload_head.size() + payload.size() + sizeof(frame_header)) % (session->config.packetsize - sizeof(NV_VIDEO_PACKET));
       if (frame_header.lastPayloadLen == 0) {
         frame_header.lastPayloadLen = session->config.packetsize - sizeof(NV_VIDEO_PACKET);
       }
@@ -1541,17 +2028,29 @@ namespace stream {
         frame_header.frame_processing_latency = 0;
       }
 
-      auto fecPercentage = config::stream.fec_percentage;
+      auto fecPercentage = session->video.fec_percentage.load();
 
-      // Insert space for packet headers
+      // Each packet is a video_packet_raw_t header followed by payload_blocksize bytes of
+      // the frame header and payload. Headers are built separately and sent with
+      // scatter-gather I/O, so the payload never has to be copied to make room for them.
       auto blocksize = session->config.packetsize + MAX_RTP_HEADER_SIZE;
       auto payload_blocksize = blocksize - sizeof(video_packet_raw_t);
-      auto payload_new = concat_and_insert(sizeof(video_packet_raw_t), payload_blocksize, std::string_view {(char *) &frame_header, sizeof(frame_header)}, payload);
+      std::string_view frame_head {(char *) &frame_header, sizeof(frame_header)};
+
+      // Rewritten parameter sets follow the frame header, ahead of the untouched payload
+      std::vector<char> frame_head_with_replacements;
+      if (!payload_head.empty()) {
+        frame_head_with_replacements.reserve(frame_head.size() + payload_head.size());
+        frame_head_with_replacements.insert(std::end(frame_head_with_replacements), std::begin(frame_head), std::end(frame_head));
+        frame_head_with_replacements.insert(std::end(frame_head_with_replacements), std::begin(payload_head), std::end(payload_head));
+        frame_head = {frame_head_with_replacements.data(), frame_head_with_replacements.size()};
+      }
 
-      payload = std::string_view {(char *) payload_new.data(), payload_new.size()};
+      auto data_size = frame_head.size() + payload.size();
+      auto data_shards_needed = (data_size + (payload_blocksize - 1)) / payload_blocksize;
 
-      // There are 2 bits for FEC block count for a maximum of 4 FEC blocks
-      constexpr auto MAX_FEC_BLOCKS = 4;
+      // Size of the frame on the wire, excluding parity and the padding of the last packet
+      auto wire_size = data_shards_needed * sizeof(video_packet_raw_t) + data_size;
 
       // The max number of data shards per block is found by solving this system of equations for D:
       // D = 255 - P
@@ -1564,46 +2063,57 @@ namespace stream {
 
       // Compute the number of FEC blocks needed for this frame using the block size and max shards
       auto max_data_per_fec_block = max_data_shards_per_fec_block * blocksize;
-      auto fec_blocks_needed = (payload.size() + (max_data_per_fec_block - 1)) / max_data_per_fec_block;
+      auto fec_blocks_needed = (wire_size + (max_data_per_fec_block - 1)) / max_data_per_fec_block;
 
-      // If the number of FEC blocks needed exceeds the protocol limit, turn off FEC for this frame.
+      // If the number of FEC blocks needed exceeds the protocol limit, lower the FEC percentage
+      // to the highest one that still fits, or turn off FEC for this frame if none does.
       // For normal FEC percentages, this should only happen for enormous frames (over 800 packets at 20%).
+      if (fec_blocks_needed > MAX_FEC_BLOCKS) {
+        auto max_percentage = rate_control::max_fec_percentage(data_shards_needed, MAX_FEC_BLOCKS, DATA_SHARDS_MAX);
+        if (max_percentage > 0) {
+          BOOST_LOG(debug) << "Lowering FEC to "sv << max_percentage << "% for large encoded frame (needed "sv << fec_blocks_needed << " FEC blocks)"sv;
+          fecPercentage = max_percentage;
+          max_data_shards_per_fec_block = (DATA_SHARDS_MAX * 100) / (100 + fecPercentage);
+          max_data_per_fec_block = max_data_shards_per_fec_block * blocksize;
+          fec_blocks_needed = (wire_size + (max_data_per_fec_block - 1)) / max_data_per_fec_block;
+        }
+      }
       if (fec_blocks_needed > MAX_FEC_BLOCKS) {
         BOOST_LOG(warning) << "Skipping FEC for abnormally large encoded frame (needed "sv << fec_blocks_needed << " FEC blocks)"sv;
         fecPercentage = 0;
         fec_blocks_needed = MAX_FEC_BLOCKS;
       }
 
-      std::array<std::string_view, MAX_FEC_BLOCKS> fec_blocks;
-      auto fec_blocks_begin = std::begin(fec_blocks);
-      auto fec_blocks_end = std::begin(fec_blocks) + fec_blocks_needed;
+      std::array<std::pair<std::string_view, std::string_view>, MAX_FEC_BLOCKS> fec_blocks;
 
       BOOST_LOG(verbose) << "Generating "sv << fec_blocks_needed << " FEC blocks"sv;
 
-      // Align individual FEC blocks to blocksize
-      auto unaligned_size = payload.size() / fec_blocks_needed;
-      auto aligned_size = ((unaligned_size + (blocksize - 1)) / blocksize) * blocksize;
+      // Align individual FEC blocks to whole packets
+      auto unaligned_shards = wire_size / fec_blocks_needed;
+      auto aligned_shards = (unaligned_shards + (blocksize - 1)) / blocksize;
 
       // If we exceed the 10-bit FEC packet index (which means our frame exceeded 4096 packets),
       // the frame will be unrecoverable. Log an error for this case.
-      if (aligned_size / blocksize >= 1024) {
-        BOOST_LOG(error) << "Encoder produced a frame too large to send! Is the encoder broken? (needed "sv << (aligned_size / blocksize) << " packets)"sv;
+      if (aligned_shards >= 1024) {
+        BOOST_LOG(error) << "Encoder produced a frame too large to send! Is the encoder broken? (needed "sv << aligned_shards << " packets)"sv;
       }
 
-      // Split the data into aligned FEC blocks
+      // Split the frame head and payload into FEC blocks of aligned_shards packets.
+      // The head normally fits into the first block, but nothing relies on it.
       for (int x = 0; x < fec_blocks_needed; ++x) {
-        if (x == fec_blocks_needed - 1) {
-          // The last block must extend to the end of the payload
-          fec_blocks[x] = payload.substr(x * aligned_size);
-        } else {
-          // Earlier blocks just extend to the next block offset
-          fec_blocks[x] = payload.substr(x * aligned_size, aligned_size);
-        }
+        auto begin = std::min(x * aligned_shards * payload_blocksize, data_size);
+        auto end = x == fec_blocks_needed - 1 ? data_size : std::min(begin + aligned_shards * payload_blocksize, data_size);
+
+        auto head_begin = std::min(begin, frame_head.size());
+        auto head_end = std::min(end, frame_head.size());
+        auto payload_begin = std::max(begin, frame_head.size()) - frame_head.size();
+        auto payload_end = std::max(end, frame_head.size()) - frame_head.size();
+
+        fec_blocks[x] = std::make_pair(frame_head.substr(head_begin, head_end - head_begin), payload.substr(payload_begin, payload_end - payload_begin));
       }
 
       try {
-        // Use around 80% of 1Gbps          1Gbps            percent    ms     packet      byte
-        size_t ratecontrol_packets_in_1ms = std::giga::num * 80 / 100 / 1000 / blocksize / 8;
+        auto &pacer = session->video.pacer;
 
         // Send less than 64K in a single batch.
         // On Windows, batches above 64K seem to bypass SO_SNDBUF regardless of its size,
@@ -1614,22 +2124,107 @@ namespace stream {
         // unusually small packet size.
         // Generic Segmentation Offload on Linux can't do more than 64.
         send_batch_size = std::min<size_t>(64, send_batch_size);
+        // A batch goes out back-to-back, so keep it within the pacer's burst size.
+        send_batch_size = std::clamp<size_t>(pacer.burst() / blocksize, 1, send_batch_size);
+
+        // RTP video timestamps use a 90 KHz clock and the frame_timestamp from when the frame was captured
+        // When a timestamp isn't available (duplicate frames), the time the pacer would send it is used instead.
+        bool frame_is_dupe = false;
+        if (!packet->frame_timestamp) {
+          packet->frame_timestamp = std::max(pacer.ready_at(), std::chrono::steady_clock::now());
+          frame_is_dupe = true;
+        }
+        using rtp_tick = std::chrono::duration<uint32_t, std::ratio<1, 90000>>;
+        uint32_t timestamp = std::chrono::round<rtp_tick>(*packet->frame_timestamp - video_epoch).count();
+
+        // Lay out every block up front, so each block knows its first sequence number
+        // and IV and can be finished independently of the others
+        for (auto &block : blocks) {
+          block.clear();
+        }
+        auto arena_allocations = arena.stats().allocations;
 
-        // Don't ignore the last ratecontrol group of the previous frame
-        auto ratecontrol_frame_start = std::max(ratecontrol_next_frame_start, std::chrono::steady_clock::now());
+        for (int blockIndex = 0; blockIndex < fec_blocks_needed; ++blockIndex) {
+          auto &block = blocks[blockIndex];
+          auto &[head, block_payload] = fec_blocks[blockIndex];
 
-        size_t ratecontrol_frame_packets_sent = 0;
-        size_t ratecontrol_group_packets_sent = 0;
+          fec::split(block.shards, arena, head, block_payload, payload_blocksize, sizeof(video_packet_raw_t), fecPercentage, session->config.minRequiredFecPackets);
 
-        auto blockIndex = 0;
-        std::for_each(fec_blocks_begin, fec_blocks_end, [&](std::string_view &current_payload) {
-          auto packets = (current_payload.size() + (blocksize - 1)) / blocksize;
+          if (block.shards.percentage != 0) {
+            auto rs_cache_hits = rs_cache.hits;
+            block.rs = rs_cache.get(block.shards.data_shards, block.shards.size() - block.shards.data_shards);
+            frame_fec_cache_hit_logger.collect_and_log(rs_cache.hits != rs_cache_hits ? 100. : 0.);
 
-          for (int x = 0; x < packets; ++x) {
-            auto *inspect = (video_packet_raw_t *) &current_payload[x * blocksize];
+            // Without an encoder, the block is still sent, just without parity shards
+            if (!block.rs) {
+              BOOST_LOG(warning) << "Couldn't create a Reed-Solomon encoder for "sv << block.shards.data_shards << '+'
+                                 << block.shards.size() - block.shards.data_shards << " shards, sending FEC block without parity"sv;
+
+              block.shards.clear();
+              fec::split(block.shards, arena, head, block_payload, payload_blocksize, sizeof(video_packet_raw_t), 0, 0);
+            }
+          }
+
+          block.lowseq = lowseq;
+          lowseq += block.shards.size();
+
+          // If video encryption is enabled, each header+payload shard is encrypted into a
+          // contiguous ciphertext buffer and sent after its encryption prefix
+          if (!session->video.ciphers.empty()) {
+            // Frames with several blocks already keep the workers busy with one block each,
+            // so only the block of a single-block frame is split across the workers
+            std::span ciphers {session->video.ciphers};
+            if (ciphers.size() == 1) {
+              // Without workers, the blocks are encrypted one after another
+              block.ciphers = ciphers;
+            } else {
+              auto block0_ciphers = ciphers.size() - (MAX_FEC_BLOCKS - 1);
+              if (blockIndex > 0) {
+                block.ciphers = ciphers.subspan(block0_ciphers + blockIndex - 1, 1);
+              } else {
+                block.ciphers = ciphers.first(fec_blocks_needed == 1 ? block0_ciphers : 1);
+              }
+            }
+            block.gcm_iv_counter = session->video.gcm_iv_counter;
+            session->video.gcm_iv_counter += block.shards.size();
+
+            block.enc_prefixes = packet_arena::buffer_t<char> {arena, block.shards.size() * block.send_header_size()};
+            block.ciphertext = packet_arena::buffer_t<char> {arena, block.shards.size() * block.send_payload_size()};
+            block.ciphertext_buffers.emplace_back(std::begin(block.ciphertext), block.ciphertext.size());
+          }
+        }
+        frame_allocations_logger.collect_and_log((double) (arena.stats().allocations - arena_allocations));
+
+        // Pick the send rate now that the size of the frame on the wire, parity included, is known
+        std::size_t frame_shards = 0;
+        for (int blockIndex = 0; blockIndex < fec_blocks_needed; ++blockIndex) {
+          frame_shards += blocks[blockIndex].shards.size();
+        }
+        if (config::stream.video_pacing) {
+          pacer.set_bitrate(session->video.target_bitrate.load());
+        }
+        auto layout_end = std::chrono::steady_clock::now();
+        pacer.begin_frame(frame_shards * blocksize, layout_end);
+        frame_pacing_rate_logger.collect_and_log(pacer.rate() * 8 / 1'000'000);
+
+        // With kernel pacing, packets are only queued a short time ahead of their launch
+        // time, so the qdisc doesn't hold (and possibly drop) a whole frame at once.
+        constexpr auto txtime_max_lead = 1ms;
+        auto txtime_block_interval = pacer.rate() > 0 ? std::chrono::nanoseconds {(std::int64_t) (blocksize * std::nano::den / pacer.rate())} : 0ns;
+
+        std::chrono::steady_clock::duration frame_pacing_delay {};
+        std::chrono::steady_clock::duration frame_send_latency {};
+
+        // Fill in the packet headers, compute parity and encrypt the whole block
+        auto prepare_block = [&](int blockIndex) {
+          auto &block = blocks[blockIndex];
+          auto &shards = block.shards;
+
+          for (int x = 0; x < shards.data_shards; ++x) {
+            auto *inspect = (video_packet_raw_t *) shards.prefix(x);
 
             inspect->packet.frameIndex = (uint32_t) packet->frame_index();
-            inspect->packet.streamPacketIndex = ((uint32_t) lowseq + x) << 8;
+            inspect->packet.streamPacketIndex = ((uint32_t) block.lowseq + x) << 8;
 
             // Match multiFecFlags with Moonlight
             inspect->packet.multiFecFlags = 0x10;
@@ -1639,45 +2234,18 @@ namespace stream {
             if (x == 0) {
               inspect->packet.flags |= FLAG_SOF;
             }
-            if (x == packets - 1) {
+            if (x == shards.data_shards - 1) {
               inspect->packet.flags |= FLAG_EOF;
             }
           }
 
-          frame_fec_latency_logger.first_point_now();
-          // If video encryption is enabled, we allocate space for the encryption header before each shard
-          auto shards = fec::encode(current_payload, blocksize, fecPercentage, session->config.minRequiredFecPackets, session->video.cipher ? sizeof(video_packet_enc_prefix_t) : 0);
-          frame_fec_latency_logger.second_point_now_and_log();
-
-          auto peer_address = session->video.peer.address();
-          auto batch_info = platf::batched_send_info_t {
-            shards.headers.begin(),
-            shards.prefixsize,
-            shards.payload_buffers,
-            shards.blocksize,
-            0,
-            0,
-            (uintptr_t) sock.native_handle(),
-            peer_address,
-            session->video.peer.port(),
-            session->localAddress,
-          };
-
-          size_t next_shard_to_send = 0;
-
-          // RTP video timestamps use a 90 KHz clock and the frame_timestamp from when the frame was captured
-          // When a timestamp isn't available (duplicate frames), the timestamp from rate control is used instead.
-          bool frame_is_dupe = false;
-          if (!packet->frame_timestamp) {
-            packet->frame_timestamp = ratecontrol_next_frame_start;
-            frame_is_dupe = true;
-          }
-          using rtp_tick = std::chrono::duration<uint32_t, std::ratio<1, 90000>>;
-          uint32_t timestamp = std::chrono::round<rtp_tick>(*packet->frame_timestamp - video_epoch).count();
+          block.fec_start = std::chrono::steady_clock::now();
+          fec::encode(block.rs, shards);
+          block.fec_end = std::chrono::steady_clock::now();
 
           // set FEC info now that we know for sure what our percentage will be for this frame
           for (auto x = 0; x < shards.size(); ++x) {
-            auto *inspect = (video_packet_raw_t *) shards.data(x);
+            auto *inspect = (video_packet_raw_t *) shards.prefix(x);
 
             inspect->packet.fecInfo =
               (uint32_t) (x << 12 |
@@ -1685,86 +2253,115 @@ namespace stream {
                           shards.percentage << 4);
 
             inspect->rtp.header = 0x80 | FLAG_EXTENSION;
-            inspect->rtp.sequenceNumber = util::endian::big<uint16_t>(lowseq + x);
+            inspect->rtp.sequenceNumber = util::endian::big<uint16_t>(block.lowseq + x);
             inspect->rtp.timestamp = util::endian::big<uint32_t>(timestamp);
 
             inspect->packet.multiFecBlocks = (blockIndex << 4) | ((fec_blocks_needed - 1) << 6);
             inspect->packet.frameIndex = (uint32_t) packet->frame_index();
+          }
 
-            // Encrypt this shard if video encryption is enabled
-            if (session->video.cipher) {
-              // We use the deterministic IV construction algorithm specified in NIST SP 800-38D
-              // Section 8.2.1. The sequence number is our "invocation" field and the 'V' in the
-              // high bytes is the "fixed" field. Because each client provides their own unique
-              // key, our values in the fixed field need only uniquely identify each independent
-              // use of the client's key with AES-GCM in our code.
-              //
-              // The IV counter is 64 bits long which allows for 2^64 encrypted video packets
-              // to be sent to each client before the IV repeats.
-              std::copy_n((uint8_t *) &session->video.gcm_iv_counter, sizeof(session->video.gcm_iv_counter), std::begin(iv));
-              iv[11] = 'V';  // Video stream
-              session->video.gcm_iv_counter++;
-
-              // Encrypt the target buffer in place
-              auto *prefix = (video_packet_enc_prefix_t *) shards.prefix(x);
-              prefix->frameNumber = (std::uint32_t) packet->frame_index();
-              std::copy(std::begin(iv), std::end(iv), prefix->iv);
-              session->video.cipher->encrypt(std::string_view {(char *) inspect, (size_t) blocksize}, prefix->tag, (uint8_t *) inspect, &iv);
+          if (block.encrypted()) {
+            encrypt_video_block(block, (std::uint32_t) packet->frame_index(), fec_pool);
+          }
+          block.encrypt_end = std::chrono::steady_clock::now();
+        };
+
+        std::array<std::future<void>, MAX_FEC_BLOCKS> prepared;
+
+        // Workers reference this frame's state, so never leave before they are done with it
+        auto wait_for_workers = util::fail_guard([&]() {
+          for (auto &future : prepared) {
+            if (future.valid()) {
+              future.wait();
             }
+          }
+        });
 
-            if (x - next_shard_to_send + 1 >= send_batch_size || x + 1 == shards.size()) {
-              // Do pacing within the frame.
-              // Also trigger pacing before the first send_batch() of the frame
-              // to account for the last send_batch() of the previous frame.
-              if (ratecontrol_group_packets_sent >= ratecontrol_packets_in_1ms || ratecontrol_frame_packets_sent == 0) {
-                auto due = ratecontrol_frame_start +
-                           std::chrono::duration_cast<std::chrono::nanoseconds>(1ms) *
-                             ratecontrol_frame_packets_sent / ratecontrol_packets_in_1ms;
-
-                auto now = std::chrono::steady_clock::now();
-                if (now < due) {
-                  timer->sleep_for(due - now);
-                }
-
-                ratecontrol_group_packets_sent = 0;
-              }
+        if (config::stream.fec_threads > 1) {
+          for (int blockIndex = 1; blockIndex < fec_blocks_needed; ++blockIndex) {
+            prepared[blockIndex] = fec_pool.push(prepare_block, blockIndex);
+          }
+        }
+
+        // Packets are always sent in order, one block after another
+        for (int blockIndex = 0; blockIndex < fec_blocks_needed; ++blockIndex) {
+          auto &block = blocks[blockIndex];
+          auto &shards = block.shards;
 
-              size_t current_batch_size = x - next_shard_to_send + 1;
-              batch_info.block_offset = next_shard_to_send;
-              batch_info.block_count = current_batch_size;
-
-              frame_send_batch_latency_logger.first_point_now();
-              // Use a batched send if it's supported on this platform
-              if (!platf::send_batch(batch_info)) {
-                // Batched send is not available, so send each packet individually
-                BOOST_LOG(verbose) << "Falling back to unbatched send"sv;
-                for (auto y = 0; y < current_batch_size; y++) {
-                  auto send_info = platf::send_info_t {
-                    shards.prefix(next_shard_to_send + y),
-                    shards.prefixsize,
-                    shards.data(next_shard_to_send + y),
-                    shards.blocksize,
-                    (uintptr_t) sock.native_handle(),
-                    peer_address,
-                    session->video.peer.port(),
-                    session->localAddress,
-                  };
-
-                  platf::send(send_info);
-                }
+          if (prepared[blockIndex].valid()) {
+            // Rethrows any exception from the worker
+            prepared[blockIndex].get();
+          } else {
+            prepare_block(blockIndex);
+          }
+
+          frame_fec_latency_logger.first_point(block.fec_start);
+          frame_fec_latency_logger.second_point_and_log(block.fec_end);
+
+          auto peer_address = session->video.peer.address();
+          auto batch_info = platf::batched_send_info_t {
+            block.send_header(0),
+            block.send_header_size(),
+            block.send_buffers(),
+            block.send_payload_size(),
+            0,
+            0,
+            (uintptr_t) sock.native_handle(),
+            peer_address,
+            session->video.peer.port(),
+            session->localAddress,
+          };
+
+          for (size_t next_shard_to_send = 0; next_shard_to_send < shards.size();) {
+            size_t current_batch_size = std::min(send_batch_size, shards.size() - next_shard_to_send);
+
+            // Wait until the pacer has enough tokens for the batch. The bucket carries
+            // its debt across frames, so the tail of the previous frame is accounted for.
+            auto now = std::chrono::steady_clock::now();
+            auto due = pacer.reserve(current_batch_size * blocksize, now);
+            pacing_stats.record(due - now);
+            frame_pacing_delay += due - now;
+
+            if (session->video.txtime) {
+              if (due - now > txtime_max_lead) {
+                timer->sleep_for(due - now - txtime_max_lead);
               }
-              frame_send_batch_latency_logger.second_point_now_and_log();
 
-              ratecontrol_group_packets_sent += current_batch_size;
-              ratecontrol_frame_packets_sent += current_batch_size;
-              next_shard_to_send = x + 1;
+              batch_info.launch_time = due;
+              batch_info.block_interval = txtime_block_interval;
+            } else if (now < due) {
+              timer->sleep_for(due - now);
             }
-          }
 
-          // remember this in case the next frame comes immediately
-          ratecontrol_next_frame_start = ratecontrol_frame_start +
-                                         std::chrono::duration_cast<std::chrono::nanoseconds>(1ms) *
-                                           ratecontrol_frame_packets_sent / ratecontrol_packets_in_1ms;
+            batch_info.block_offset = next_shard_to_send;
+            batch_info.block_count = current_batch_size;
+
+            auto send_start = std::chrono::steady_clock::now();
+            frame_send_batch_latency_logger.first_point_now();
+            // Use a batched send if it's supported on this platform
+            if (!platf::send_batch(batch_info)) {
+              // Batched send is not available, so send each packet individually
+              BOOST_LOG(verbose) << "Falling back to unbatched send"sv;
+              for (auto y = 0; y < current_batch_size; y++) {
+                auto send_info = platf::send_info_t {
+                  block.send_header(next_shard_to_send + y),
+                  block.send_header_size(),
+                  block.send_payload(next_shard_to_send + y),
+                  block.send_payload_size(),
+                  (uintptr_t) sock.native_handle(),
+                  peer_address,
+                  session->video.peer.port(),
+                  session->localAddress,
+                };
+
+                platf::send(send_info);
+              }
+            }
+            frame_send_batch_latency_logger.second_point_now_and_log();
+            frame_send_latency += std::chrono::steady_clock::now() - send_start;
+
+            next_shard_to_send += current_batch_size;
+          }
 
           frame_network_latency_logger.second_point_now_and_log();
 
@@ -1774,32 +2371,116 @@ namespace stream {
                              << (packet->is_idr() ? " Key" : "")
                              << (packet->after_ref_frame_invalidation ? " RFI" : "");
 
-          ++blockIndex;
-          lowseq += shards.size();
-        });
+          // The audio sender compares its own latency against this to measure the A/V skew
+          if (!frame_is_dupe) {
+            session->video.frame_latency_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - *packet->frame_timestamp).count();
+          }
+        }
+
+        frame_pacing_delay_logger.collect_and_log(std::chrono::duration<double, std::milli>(frame_pacing_delay).count());
+        session->video.packets_sent += frame_shards;
+
+        // Only this thread raises the maxima, so a plain store can't lose a larger value
+        auto send_latency_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(frame_send_latency).count();
+        if (send_latency_ns > session->video.max_send_latency_ns.load()) {
+          session->video.max_send_latency_ns = send_latency_ns;
+        }
+        if (queue_depth > session->video.max_queue_depth.load()) {
+          session->video.max_queue_depth = queue_depth;
+        }
+
+#ifdef SUNSHINE_TESTS
+        if (auto stats = session->video.send_stats) {
+          ++stats->frames;
+          stats->packets += frame_shards;
+          for (int blockIndex = 0; blockIndex < fec_blocks_needed; ++blockIndex) {
+            auto &block = blocks[blockIndex];
+            stats->bytes += block.shards.size() * (block.send_header_size() + block.send_payload_size());
+            stats->fec_time += block.fec_end - block.fec_start;
+            stats->encrypt_time += block.encrypt_end - block.fec_end;
+          }
+          stats->packetize_time += layout_end - frame_start;
+          stats->send_time += frame_send_latency;
+          stats->frame_latencies.emplace_back(std::chrono::steady_clock::now() - frame_start);
+          stats->frame_allocations.emplace_back(arena.stats().allocations - arena_allocations);
+        }
+#endif
 
         session->video.lowseq = lowseq;
       } catch (const std::exception &e) {
         BOOST_LOG(error) << "Broadcast video failed "sv << e.what();
         std::this_thread::sleep_for(100ms);
       }
+
+      // The frame has been sent and no worker holds an encoder anymore
+      rs_cache.trim();
     }
 
-    shutdown_event->raise(true);
+    BOOST_LOG(debug) << "FEC encoder cache: "sv << rs_cache.hits << " hits, "sv << rs_cache.misses << " misses"sv;
+    BOOST_LOG(debug) << "Packet arena: "sv << arena.stats().acquired << " buffers, "sv << arena.stats().allocations << " allocations"sv;
+    BOOST_LOG(debug) << "Pacer: "sv << pacing_stats.delayed_batches << " of "sv << pacing_stats.batches << " batches delayed, "sv
+                     << std::chrono::duration<double, std::milli>(pacing_stats.total_delay).count() << "ms total, "sv
+                     << std::chrono::duration<double, std::milli>(pacing_stats.max_delay).count() << "ms at most"sv;
+
+    auto queue_stats = packets.stats();
+    BOOST_LOG(debug) << "Video send queue: "sv << queue_stats.high_water << " frames at most, "sv << queue_stats.dropped << " dropped"sv;
   }
 
   /**
-   * @brief Run the broadcast audio sender thread.
+   * @brief Run a video sender thread that serves a single session or a shard of sessions.
    *
    * @param sock Socket used to read or write the protocol message.
+   * @param packets Queue of encoded frames routed to this sender.
    */
-  void audioBroadcastThread(udp::socket &sock) {
+  void videoSendThread(udp::socket &sock, std::shared_ptr<safe::queue_t<video::packet_t>> packets) {
+    platf::set_thread_name("stream::videoSend");
+
+    videoSendLoop(sock, *packets);
+  }
+
+  /**
+   * @brief Run the broadcast video sender thread.
+   *
+   * With a single sender, frames of every session are sent from this thread.
+   * Otherwise this thread only routes each frame to its session's sender queue.
+   *
+   * @param sock Socket used to read or write the protocol message.
+   */
+  void videoBroadcastThread(udp::socket &sock) {
     auto shutdown_event = mail::man->event<bool>(mail::broadcast_shutdown);
-    auto packets = mail::man->queue<audio::packet_t>(mail::audio_packets);
+    auto packets = mail::man->queue<video::packet_t>(mail::video_packets);
 
-    audio_packet_t audio_packet;
+    // Video traffic is sent on this thread
+    platf::set_thread_name("stream::videoBroadcast");
+
+    if (config::stream.video_senders == 1) {
+      videoSendLoop(sock, *packets);
+      shutdown_event->raise(true);
+      return;
+    }
+
+    platf::adjust_thread_priority(platf::thread_priority_e::high);
+
+    while (auto packet = packets->pop()) {
+      auto session = (session_t *) packet->channel_data;
+
+      // The queue is set before the session starts capturing, so it is always present here
+      session->video.send_queue->raise(std::move(packet));
+    }
+
+    shutdown_event->raise(true);
+  }
+
+  /**
+   * @brief Create the Reed-Solomon encoder of the audio parity shards.
+   *
+   * @return Encoder, or `nullptr` if it couldn't be created.
+   */
+  static fec::rs_t make_audio_rs() {
     fec::rs_t rs {reed_solomon_new(RTPA_DATA_SHARDS, RTPA_FEC_SHARDS)};
-    crypto::aes_t iv(16);
+    if (!rs) {
+      return rs;
+    }
 
     // For unknown reasons, the RS parity matrix computed by our RS implementation
     // doesn't match the one Nvidia uses for audio data. I'm not exactly sure why,
@@ -1807,22 +2488,42 @@ namespace stream {
     // works correctly. This is possible because the data and FEC shard count is
     // constant and known in advance.
     constexpr std::array<unsigned char, 8> parity {0x77, 0x40, 0x38, 0x0e, 0xc7, 0xa7, 0x0d, 0x6c};
-    memcpy(rs.get()->p, parity.data(), parity.size());
+    memcpy(rs->p, parity.data(), parity.size());
+
+    return rs;
+  }
+
+  /**
+   * @brief Send the audio packets popped from a queue until it is stopped.
+   *
+   * @param sock Socket used to read or write the protocol message.
+   * @param packets Queue of encoded audio packets to send.
+   * @param rs Encoder of the parity shards, audio is sent without FEC when it is `nullptr`.
+   */
+  static void audioSendLoop(udp::socket &sock, safe::queue_t<audio::packet_t> &packets, reed_solomon *rs) {
+    auto shutdown_event = mail::man->event<bool>(mail::broadcast_shutdown);
+
+    audio_packet_t audio_packet;
+    crypto::aes_t iv(16);
+
+    // Headers and payload descriptors of the parity packets, reused for every FEC block
+    std::array<audio_fec_packet_t, RTPA_FEC_SHARDS> fec_headers;
+    std::vector<platf::buffer_descriptor_t> fec_buffers;
+    fec_buffers.reserve(RTPA_FEC_SHARDS);
 
     audio_packet.rtp.header = 0x80;
     audio_packet.rtp.packetType = 97;
     audio_packet.rtp.ssrc = 0;
 
-    // Audio traffic is sent on this thread
-    platf::set_thread_name("stream::audioBroadcast");
-    platf::adjust_thread_priority(platf::thread_priority_e::high);
+    logging::min_max_avg_periodic_logger<double> audio_latency_logger(debug, "Audio: capture to send latency", "ms");
+    logging::min_max_avg_periodic_logger<double> av_skew_logger(debug, "Audio/video skew (audio latency minus video latency)", "ms");
 
-    while (auto packet = packets->pop()) {
+    while (auto packet = packets.pop()) {
       if (shutdown_event->peek()) {
         break;
       }
 
-      TUPLE_2D_REF(channel_data, packet_data, *packet);
+      TUPLE_3D_REF(channel_data, packet_data, capture_timestamp, *packet);
       auto session = (session_t *) channel_data;
 
       auto sequenceNumber = session->audio.sequenceNumber;
@@ -1832,7 +2533,7 @@ namespace stream {
 
       auto &shards_p = session->audio.shards_p;
 
-      auto bytes = encode_audio(session->config.encryptionFlagsEnabled & SS_ENC_AUDIO, packet_data, shards_p[sequenceNumber % RTPA_DATA_SHARDS], iv, session->audio.cipher);
+      auto bytes = encode_audio(session->config.encryptionFlagsEnabled & SS_ENC_AUDIO, *packet_data, shards_p[sequenceNumber % RTPA_DATA_SHARDS], iv, session->audio.cipher);
       if (bytes < 0) {
         BOOST_LOG(error) << "Couldn't encode audio packet"sv;
         break;
@@ -1868,33 +2569,87 @@ namespace stream {
         }
 
         // generate parity shards at the end of the FEC block
-        if ((sequenceNumber + 1) % RTPA_DATA_SHARDS == 0) {
-          reed_solomon_encode(rs.get(), shards_p.begin(), RTPA_TOTAL_SHARDS, bytes);
+        if (rs && (sequenceNumber + 1) % RTPA_DATA_SHARDS == 0) {
+          gf256::encode(rs->p, RTPA_DATA_SHARDS, RTPA_FEC_SHARDS, shards_p.begin(), bytes);
 
+          // The parity packets of the block go out together in a single batch
+          fec_buffers.clear();
           for (auto x = 0; x < RTPA_FEC_SHARDS; ++x) {
-            fec_packet.rtp.sequenceNumber = util::endian::big<std::uint16_t>(sequenceNumber + x + 1);
-            fec_packet.fecHeader.fecShardIndex = x;
-
-            auto send_info = platf::send_info_t {
-              (const char *) &fec_packet,
-              sizeof(fec_packet),
-              (const char *) shards_p[RTPA_DATA_SHARDS + x],
-              (size_t) bytes,
-              (uintptr_t) sock.native_handle(),
-              peer_address,
-              session->audio.peer.port(),
-              session->localAddress,
-            };
-            platf::send(send_info);
-            BOOST_LOG(verbose) << "Audio FEC ["sv << (sequenceNumber & ~(RTPA_DATA_SHARDS - 1)) << ' ' << x << "] ::  send..."sv;
+            fec_headers[x] = fec_packet;
+            fec_headers[x].rtp.sequenceNumber = util::endian::big<std::uint16_t>(sequenceNumber + x + 1);
+            fec_headers[x].fecHeader.fecShardIndex = x;
+
+            fec_buffers.push_back({(const char *) shards_p[RTPA_DATA_SHARDS + x], (size_t) bytes});
           }
+
+          platf::batched_send_info_t batch_info {
+            (const char *) fec_headers.data(),
+            sizeof(audio_fec_packet_t),
+            fec_buffers,
+            (size_t) bytes,
+            0,
+            RTPA_FEC_SHARDS,
+            (uintptr_t) sock.native_handle(),
+            peer_address,
+            session->audio.peer.port(),
+            session->localAddress,
+          };
+
+          if (!platf::send_batch(batch_info)) {
+            // Batched send is not available, so send each packet individually
+            for (auto x = 0; x < RTPA_FEC_SHARDS; ++x) {
+              auto send_info = platf::send_info_t {
+                (const char *) &fec_headers[x],
+                sizeof(audio_fec_packet_t),
+                (const char *) shards_p[RTPA_DATA_SHARDS + x],
+                (size_t) bytes,
+                (uintptr_t) sock.native_handle(),
+                peer_address,
+                session->audio.peer.port(),
+                session->localAddress,
+              };
+              platf::send(send_info);
+            }
+          }
+          BOOST_LOG(verbose) << "Audio FEC ["sv << (sequenceNumber & ~(RTPA_DATA_SHARDS - 1)) << "] ::  send..."sv;
         }
       } catch (const std::exception &e) {
         BOOST_LOG(error) << "Broadcast audio failed "sv << e.what();
         std::this_thread::sleep_for(100ms);
       }
+
+      // Positive skew means the audio of a moment reaches the client later than its video
+      auto audio_latency = std::chrono::steady_clock::now() - capture_timestamp;
+      audio_latency_logger.collect_and_log(std::chrono::duration<double, std::milli>(audio_latency).count());
+      if (auto video_latency_ns = session->video.frame_latency_ns.load(); video_latency_ns >= 0) {
+        av_skew_logger.collect_and_log(std::chrono::duration<double, std::milli>(audio_latency - std::chrono::nanoseconds {video_latency_ns}).count());
+      }
+    }
+
+    auto queue_stats = packets.stats();
+    BOOST_LOG(debug) << "Audio packet queue: "sv << queue_stats.high_water << " packets at most, "sv << queue_stats.dropped << " dropped"sv;
+  }
+
+  /**
+   * @brief Run the broadcast audio sender thread.
+   *
+   * @param sock Socket used to read or write the protocol message.
+   */
+  void audioBroadcastThread(udp::socket &sock) {
+    auto shutdown_event = mail::man->event<bool>(mail::broadcast_shutdown);
+    auto packets = mail::man->queue<audio::packet_t>(mail::audio_packets);
+
+    auto rs = make_audio_rs();
+    if (!rs) {
+      BOOST_LOG(error) << "Couldn't create the audio Reed-Solomon encoder, sending audio without FEC"sv;
     }
 
+    // Audio traffic is sent on this thread
+    platf::set_thread_name("stream::audioBroadcast");
+    platf::adjust_thread_priority(platf::thread_priority_e::high);
+
+    audioSendLoop(sock, *packets, rs.get());
+
     shutdown_event->raise(true);
   }
 
@@ -1943,6 +2698,15 @@ namespace stream {
       return -1;
     }
 
+    // Let the kernel pace video packets if requested, otherwise the sender sleeps between batches
+    ctx.video_txtime = false;
+    if (config::stream.video_txtime) {
+      ctx.video_txtime = platf::enable_socket_txtime(ctx.video_sock.native_handle());
+      if (!ctx.video_txtime) {
+        BOOST_LOG(warning) << "Kernel pacing is unavailable, video will be paced by the sender thread"sv;
+      }
+    }
+
     ctx.audio_sock.open(protocol, ec);
     if (ec) {
       BOOST_LOG(fatal) << "Couldn't open socket for Audio server: "sv << ec.message();
@@ -1959,6 +2723,15 @@ namespace stream {
 
     ctx.message_queue_queue = std::make_shared<message_queue_queue_t::element_type>(30);
 
+    // With a fixed number of sender shards, sessions are spread across them as they start
+    if (config::stream.video_senders > 1) {
+      ctx.next_video_shard = 0;
+      for (auto x = 0; x < config::stream.video_senders; ++x) {
+        auto &queue = ctx.video_shard_queues.emplace_back(std::make_shared<safe::queue_t<video::packet_t>>(32));
+        ctx.video_shard_threads.emplace_back(videoSendThread, std::ref(ctx.video_sock), queue);
+      }
+    }
+
     ctx.video_thread = std::jthread {videoBroadcastThread, std::ref(ctx.video_sock)};
     ctx.audio_thread = std::jthread {audioBroadcastThread, std::ref(ctx.audio_sock)};
     ctx.control_thread = std::jthread {controlBroadcastThread, &ctx.control_server};
@@ -1982,6 +2755,9 @@ namespace stream {
     // Minimize delay stopping video/audio threads
     video_packets->stop();
     audio_packets->stop();
+    for (auto &queue : ctx.video_shard_queues) {
+      queue->stop();
+    }
 
     ctx.message_queue_queue->stop();
     ctx.io_context.stop();
@@ -1996,6 +2772,11 @@ namespace stream {
     ctx.recv_thread.join();
     BOOST_LOG(debug) << "Waiting for main video thread to end..."sv;
     ctx.video_thread.join();
+    for (auto &thread : ctx.video_shard_threads) {
+      thread.join();
+    }
+    ctx.video_shard_threads.clear();
+    ctx.video_shard_queues.clear();
     BOOST_LOG(debug) << "Waiting for main audio thread to end..."sv;
     ctx.audio_thread.join();
     BOOST_LOG(debug) << "Waiting for main control thread to end..."sv;
@@ -2092,6 +2873,31 @@ namespace stream {
     auto address = session->video.peer.address();
     session->video.qos = platf::enable_socket_qos(ref->video_sock.native_handle(), address, session->video.peer.port(), platf::qos_data_type_e::video, session->config.videoQosType != 0);
 
+    // Launch times are silently dropped by qdiscs that don't pace, so only rely on them where they are honored
+    session->video.txtime = false;
+    if (ref->video_txtime) {
+      session->video.txtime = platf::interface_honors_txtime(session->localAddress.to_string());
+      if (!session->video.txtime) {
+        BOOST_LOG(warning) << "The interface of "sv << session->localAddress.to_string() << " doesn't use the fq or etf qdisc, video will be paced by the sender thread"sv;
+      }
+    }
+
+    // Pick the sender for this session's frames unless every session shares one
+    std::jthread sender;
+    auto stop_sender = util::fail_guard([&]() {
+      if (sender.joinable()) {
+        session->video.send_queue->stop();
+      }
+    });
+    if (config::stream.video_senders == 0) {
+      session->video.send_queue = std::make_shared<safe::queue_t<video::packet_t>>(32);
+      sender = std::jthread {videoSendThread, std::ref(ref->video_sock), session->video.send_queue};
+    } else if (config::stream.video_senders > 1) {
+      auto shard = ref->next_video_shard++ % ref->video_shard_queues.size();
+      session->video.send_queue = ref->video_shard_queues[shard];
+      BOOST_LOG(debug) << "Sending video from sender shard "sv << shard;
+    }
+
     BOOST_LOG(debug) << "Start capturing Video"sv;
     video::capture(session->mail, session->config.monitor, session);
   }
@@ -2278,12 +3084,65 @@ namespace stream {
       session->video.invalidate_ref_frames_events = mail->event<std::pair<int64_t, int64_t>>(mail::invalidate_ref_frames);
       session->video.lowseq = 0;
       session->video.ping_payload = launch_session.av_ping_payload;
+      session->video.fec_percentage = config::stream.fec_percentage;
+      session->video.packets_sent = 0;
+      session->video.packets_sent_at_loss_report = 0;
+      if (config::stream.fec_adaptive) {
+        session->video.fec_controller = rate_control::fec_controller_t {
+          rate_control::fec_params_t {
+            config::stream.fec_min_percentage,
+            config::stream.fec_max_percentage,
+          },
+          config::stream.fec_percentage,
+          std::chrono::steady_clock::now(),
+        };
+        session->video.fec_percentage = session->video.fec_controller.percentage();
+      }
+      session->video.target_bitrate = config.monitor.bitrate;
+      session->video.max_send_latency_ns = 0;
+      session->video.max_queue_depth = 0;
+      session->video.frame_latency_ns = -1;
+      session->video.bitrate_events = mail->event<int>(mail::bitrate);
+      if (config::stream.video_adaptive_bitrate) {
+        auto max_bitrate = config::video.max_bitrate > 0 ? std::min(config.monitor.bitrate, config::video.max_bitrate) : config.monitor.bitrate;
+
+        rate_control::bitrate_params_t params {
+          std::max(max_bitrate * config::stream.video_min_bitrate_percentage / 100, 1),
+          max_bitrate,
+          // A frame that takes more than half its interval to hand to the kernel is falling behind
+          std::chrono::nanoseconds {std::nano::den / std::max(config.monitor.framerate, 1) / 2},
+        };
+        session->video.bitrate_controller = rate_control::bitrate_controller_t {params, std::chrono::steady_clock::now()};
+        session->video.target_bitrate = session->video.bitrate_controller.target();
+      }
+      session->video.txtime = false;
+      std::chrono::nanoseconds frame_interval {std::nano::den / std::max(config.monitor.framerate, 1)};
+      if (config::stream.video_pacing) {
+        session->video.pacer = pacer::token_bucket_t {pacer::params_t {
+          config.monitor.bitrate,
+          config::stream.video_pacing_headroom,
+          (std::size_t) config::stream.video_pacing_burst * (config.packetsize + MAX_RTP_HEADER_SIZE),
+          frame_interval,
+          config::stream.video_pacing_spread,
+        }};
+      } else {
+        // Use around 80% of 1Gbps in groups of 1ms, whatever the bitrate
+        session->video.pacer = pacer::token_bucket_t {pacer::params_t {
+          FIXED_PACING_RATE_KBPS,
+          100,
+          (std::size_t) FIXED_PACING_RATE_KBPS * 1000 / 8 / 1000,
+          frame_interval,
+          0,
+        }};
+      }
       if (config.encryptionFlagsEnabled & SS_ENC_VIDEO) {
         BOOST_LOG(info) << "Video encryption enabled"sv;
-        session->video.cipher = crypto::cipher::gcm_t {
-          launch_session.gcm_key,
-          false
-        };
+
+        // Blocks only need their own ciphers when they are encrypted concurrently
+        auto nr_ciphers = config::stream.fec_threads > 1 ? config::stream.fec_threads + MAX_FEC_BLOCKS - 1 : 1;
+        for (auto x = 0; x < nr_ciphers; ++x) {
+          session->video.ciphers.emplace_back(launch_session.gcm_key, false);
+        }
         session->video.gcm_iv_counter = 0;
       }
 
@@ -2318,6 +3177,10 @@ namespace stream {
       session->audio.avRiKeyId = util::endian::big(*(std::uint32_t *) launch_session.iv.data());
       session->audio.sequenceNumber = 0;
       session->audio.timestamp = 0;
+      session->audio.settings_events = mail->event<rate_control::audio_settings_t>(mail::audio_settings);
+      if (config::stream.audio_adaptive) {
+        session->audio.controller = rate_control::audio_controller_t {rate_control::audio_params_t {}, std::chrono::steady_clock::now()};
+      }
 
       session->control.peer = nullptr;
       session->state.store(state_e::STOPPED, std::memory_order_relaxed);
@@ -2327,4 +3190,82 @@ namespace stream {
       return session;
     }
   }  // namespace session
+
+#ifdef SUNSHINE_TESTS
+  namespace testing {
+    video_send_stats_t replay_video(session_t &session, const std::vector<recorded_frame_t> &frames, std::uint16_t port) {
+      asio::io_context io;
+      udp::socket sock {io, udp::endpoint {asio::ip::address_v4::loopback(), 0}};
+
+      session.video.peer = udp::endpoint {asio::ip::address_v4::loopback(), port};
+      session.localAddress = asio::ip::address_v4::loopback();
+      session.video.txtime = false;
+
+      // Random bytes never match a replacement, like real slice data
+      std::size_t max_size = 0;
+      for (auto &frame : frames) {
+        max_size = std::max(max_size, frame.size);
+      }
+      std::vector<uint8_t> random_bytes(max_size);
+      std::independent_bits_engine<std::default_random_engine, 8, uint16_t> engine;
+      std::generate(std::begin(random_bytes), std::end(random_bytes), std::ref(engine));
+
+      safe::queue_t<video::packet_t> packets;
+      video_send_stats_t stats;
+      session.video.send_stats = &stats;
+      auto reset_stats = util::fail_guard([&]() {
+        session.video.send_stats = nullptr;
+      });
+
+      std::thread sender {[&]() {
+        videoSendLoop(sock, packets);
+      }};
+
+      auto start = std::chrono::steady_clock::now();
+      for (std::size_t x = 0; x < frames.size(); ++x) {
+        auto packet = std::make_unique<video::packet_raw_generic>(std::vector<uint8_t> {std::begin(random_bytes), std::begin(random_bytes) + frames[x].size}, x + 1, frames[x].idr);
+        packet->channel_data = &session;
+        packet->frame_timestamp = start + frames[x].timestamp;
+
+        std::this_thread::sleep_until(*packet->frame_timestamp);
+        packets.raise(std::move(packet));
+      }
+
+      // The sender finishes the frame it is working on before it sees the queue stop
+      while (packets.size() > 0) {
+        std::this_thread::sleep_for(1ms);
+      }
+      packets.stop();
+      sender.join();
+
+      return stats;
+    }
+
+    void replay_audio(session_t &session, std::size_t packet_count, std::uint16_t port, bool fec) {
+      asio::io_context io;
+      udp::socket sock {io, udp::endpoint {asio::ip::address_v4::loopback(), 0}};
+
+      session.audio.peer = udp::endpoint {asio::ip::address_v4::loopback(), port};
+      session.localAddress = asio::ip::address_v4::loopback();
+
+      auto rs = fec ? make_audio_rs() : nullptr;
+
+      safe::queue_t<audio::packet_t> packets {32, safe::overflow_e::block};
+      std::thread sender {[&]() {
+        audioSendLoop(sock, packets, rs.get());
+      }};
+
+      for (std::size_t x = 0; x < packet_count; ++x) {
+        packets.raise(&session, safe::pooled_t<audio::buffer_t> {nullptr, audio::buffer_t(160)}, std::chrono::steady_clock::now());
+      }
+
+      // The sender finishes the packet it is working on before it sees the queue stop
+      while (packets.size() > 0) {
+        std::this_thread::sleep_for(1ms);
+      }
+      packets.stop();
+      sender.join();
+    }
+  }  // namespace testing
+#endif
 }  // namespace stream
@@ -5,7 +5,10 @@
 #pragma once
 
 // standard includes
+#include <chrono>
+#include <cstdint>
 #include <utility>
+#include <vector>
 
 // lib includes
 #include <boost/asio.hpp>
@@ -95,4 +98,55 @@ namespace stream {
      */
     const std::string &client_cert(session_t &session);
   }  // namespace session
+
+#ifdef SUNSHINE_TESTS
+  namespace testing {
+    /**
+     * @brief Work done by a video sender, split by stage.
+     */
+    struct video_send_stats_t {
+      std::uint64_t frames = 0;  ///< Frames sent.
+      std::uint64_t packets = 0;  ///< Data and parity packets sent.
+      std::uint64_t bytes = 0;  ///< Bytes handed to the socket, packet headers included.
+      std::chrono::nanoseconds packetize_time {};  ///< Time spent splitting frames into FEC blocks.
+      std::chrono::nanoseconds fec_time {};  ///< Time spent computing parity, summed over blocks.
+      std::chrono::nanoseconds encrypt_time {};  ///< Time spent encrypting packets, summed over blocks.
+      std::chrono::nanoseconds send_time {};  ///< Time spent in send calls.
+      std::vector<std::chrono::nanoseconds> frame_latencies;  ///< Time from dequeuing each frame until its last packet was sent.
+      std::vector<std::uint64_t> frame_allocations;  ///< Buffers the packet arena allocated from the heap for each frame.
+    };
+
+    /**
+     * @brief Encoded frame of a recorded video stream.
+     */
+    struct recorded_frame_t {
+      std::chrono::microseconds timestamp;  ///< Time of the frame since the start of the recording.
+      std::size_t size;  ///< Encoded size of the frame in bytes.
+      bool idr;  ///< Whether the frame is an IDR frame.
+    };
+
+    /**
+     * @brief Send recorded frames of a session through the video sender to a local UDP port.
+     *
+     * Frames are filled with random bytes and queued at their recorded times, so the sender
+     * sees the same load as with a live encoder. No client or GPU is needed.
+     *
+     * @param session Session allocated with session::alloc(), it must not be started.
+     * @param frames Frames to send, ordered by timestamp.
+     * @param port Loopback port the packets are sent to.
+     * @return Counters of the video sender after the last frame was sent.
+     */
+    video_send_stats_t replay_video(session_t &session, const std::vector<recorded_frame_t> &frames, std::uint16_t port);
+
+    /**
+     * @brief Send audio packets of a session through the audio sender to a local UDP port.
+     *
+     * @param session Session allocated with session::alloc(), it must not be started.
+     * @param packet_count Number of audio packets to send.
+     * @param port Loopback port the packets are sent to.
+     * @param fec Whether the sender gets an encoder for the parity shards, or has to do without.
+     */
+    void replay_audio(session_t &session, std::size_t packet_count, std::uint16_t port, bool fec);
+  }  // namespace testing
+#endif
 }  // namespace stream
@@ -5,13 +5,16 @@
 #pragma once
 
 // standard includes
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <deque>
 #include <functional>
 #include <future>
 #include <mutex>
 #include <optional>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -102,8 +105,41 @@ namespace task_pool_util {
     };
 
   protected:
+    /**
+     * @brief Delayed task waiting for its due time.
+     */
+    struct timer_t {
+      __time_point time_point;  ///< Time the task becomes runnable.
+      std::uint64_t seq;  ///< Sequence number of the heap entry that is currently valid for the task.
+      __task task;  ///< Task to run.
+    };
+
+    /**
+     * @brief Entry of the timer heap, ordered by due time and then by scheduling order.
+     *
+     * Cancelling or delaying a task leaves its old entry in the heap. Such entries are
+     * recognized by their sequence number and skipped.
+     */
+    struct timer_entry_t {
+      __time_point time_point;  ///< Time the task becomes runnable.
+      std::uint64_t seq;  ///< Sequence number of the entry.
+      task_id_t task_id;  ///< Task the entry belongs to.
+
+      /**
+       * @brief Order entries so the heap keeps the earliest one on top.
+       *
+       * @param other Entry to compare against.
+       * @return True when this entry is due after `other`.
+       */
+      bool operator>(const timer_entry_t &other) const {
+        return time_point > other.time_point || (time_point == other.time_point && seq > other.seq);
+      }
+    };
+
     std::deque<__task> _tasks;  ///< Immediate tasks waiting for worker execution.
-    std::vector<std::pair<__time_point, __task>> _timer_tasks;  ///< Delayed tasks sorted by their due time.
+    std::unordered_map<task_id_t, timer_t> _timer_tasks;  ///< Delayed tasks by their ID.
+    std::vector<timer_entry_t> _timer_heap;  ///< Min-heap of the due times of delayed tasks, may hold stale entries.
+    std::uint64_t _timer_seq = 0;  ///< Sequence number of the next heap entry.
     std::mutex _task_mutex;  ///< Mutex protecting task queues and worker wakeups.
 
   public:
@@ -116,7 +152,9 @@ namespace task_pool_util {
      */
     TaskPool(TaskPool &&other) noexcept:
         _tasks {std::move(other._tasks)},
-        _timer_tasks {std::move(other._timer_tasks)} {
+        _timer_tasks {std::move(other._timer_tasks)},
+        _timer_heap {std::move(other._timer_heap)},
+        _timer_seq {other._timer_seq} {
     }
 
     /**
@@ -128,6 +166,8 @@ namespace task_pool_util {
     TaskPool &operator=(TaskPool &&other) noexcept {
       std::swap(_tasks, other._tasks);
       std::swap(_timer_tasks, other._timer_tasks);
+      std::swap(_timer_heap, other._timer_heap);
+      std::swap(_timer_seq, other._timer_seq);
 
       return *this;
     }
@@ -168,14 +208,9 @@ namespace task_pool_util {
     void pushDelayed(std::pair<__time_point, __task> &&task) {
       std::lock_guard lg(_task_mutex);
 
-      auto it = _timer_tasks.cbegin();
-      for (; it < _timer_tasks.cend(); ++it) {
-        if (std::get<0>(*it) < task.first) {
-          break;
-        }
-      }
-
-      _timer_tasks.emplace(it, task.first, std::move(task.second));
+      task_id_t task_id = &*task.second;
+      auto seq = push_timer_entry(task.first, task_id);
+      _timer_tasks.insert_or_assign(task_id, timer_t {task.first, seq, std::move(task.second)});
     }
 
     /**
@@ -223,31 +258,17 @@ namespace task_pool_util {
     void delay(task_id_t task_id, std::chrono::duration<X, Y> duration) {
       std::lock_guard<std::mutex> lg(_task_mutex);
 
-      auto it = _timer_tasks.begin();
-      for (; it < _timer_tasks.cend(); ++it) {
-        const __task &task = std::get<1>(*it);
-
-        if (&*task == task_id) {
-          std::get<0>(*it) = std::chrono::steady_clock::now() + duration;
-
-          break;
-        }
-      }
-
-      if (it == _timer_tasks.cend()) {
+      auto it = _timer_tasks.find(task_id);
+      if (it == std::end(_timer_tasks)) {
         return;
       }
 
-      // smaller time goes to the back
-      auto prev = it - 1;
-      while (it > _timer_tasks.cbegin()) {
-        if (std::get<0>(*it) > std::get<0>(*prev)) {
-          std::swap(*it, *prev);
-        }
+      // The entry with the previous due time goes stale
+      auto &timer = it->second;
+      timer.time_point = std::chrono::steady_clock::now() + duration;
+      timer.seq = push_timer_entry(timer.time_point, task_id);
 
-        --prev;
-        --it;
-      }
+      compact_timer_heap();
     }
 
     /**
@@ -259,18 +280,13 @@ namespace task_pool_util {
     bool cancel(task_id_t task_id) {
       std::lock_guard lg(_task_mutex);
 
-      auto it = _timer_tasks.begin();
-      for (; it < _timer_tasks.cend(); ++it) {
-        const __task &task = std::get<1>(*it);
-
-        if (&*task == task_id) {
-          _timer_tasks.erase(it);
-
-          return true;
-        }
+      // The heap entry of the task goes stale and is skipped once it reaches the top
+      if (!_timer_tasks.erase(task_id)) {
+        return false;
       }
 
-      return false;
+      compact_timer_heap();
+      return true;
     }
 
     /**
@@ -282,15 +298,13 @@ namespace task_pool_util {
     std::optional<std::pair<__time_point, __task>> pop(task_id_t task_id) {
       std::lock_guard lg(_task_mutex);
 
-      auto pos = std::find_if(std::begin(_timer_tasks), std::end(_timer_tasks), [&task_id](const auto &t) {
-        return t.second.get() == task_id;
-      });
-
-      if (pos == std::end(_timer_tasks)) {
+      auto node = _timer_tasks.extract(task_id);
+      if (!node) {
         return std::nullopt;
       }
 
-      return std::move(*pos);
+      compact_timer_heap();
+      return std::pair {node.mapped().time_point, std::move(node.mapped().task)};
     }
 
     /**
@@ -307,10 +321,14 @@ namespace task_pool_util {
         return task;
       }
 
-      if (!_timer_tasks.empty() && std::get<0>(_timer_tasks.back()) <= std::chrono::steady_clock::now()) {
-        __task task = std::move(std::get<1>(_timer_tasks.back()));
-        _timer_tasks.pop_back();
-        return task;
+      auto top = next_timer_entry();
+      if (top && top->time_point <= std::chrono::steady_clock::now()) {
+        auto task_id = top->task_id;
+        std::pop_heap(std::begin(_timer_heap), std::end(_timer_heap), std::greater<> {});
+        _timer_heap.pop_back();
+
+        auto node = _timer_tasks.extract(task_id);
+        return std::move(node.mapped().task);
       }
 
       return std::nullopt;
@@ -324,7 +342,12 @@ namespace task_pool_util {
     bool ready() {
       std::lock_guard<std::mutex> lg(_task_mutex);
 
-      return !_tasks.empty() || (!_timer_tasks.empty() && std::get<0>(_timer_tasks.back()) <= std::chrono::steady_clock::now());
+      if (!_tasks.empty()) {
+        return true;
+      }
+
+      auto top = next_timer_entry();
+      return top && top->time_point <= std::chrono::steady_clock::now();
     }
 
     /**
@@ -335,14 +358,63 @@ namespace task_pool_util {
     std::optional<__time_point> next() {
       std::lock_guard<std::mutex> lg(_task_mutex);
 
-      if (_timer_tasks.empty()) {
+      auto top = next_timer_entry();
+      if (!top) {
         return std::nullopt;
       }
 
-      return std::get<0>(_timer_tasks.back());
+      return top->time_point;
     }
 
   private:
+    // The helpers below must be called with _task_mutex held
+
+    std::uint64_t push_timer_entry(__time_point time_point, task_id_t task_id) {
+      auto seq = _timer_seq++;
+
+      _timer_heap.push_back({time_point, seq, task_id});
+      std::push_heap(std::begin(_timer_heap), std::end(_timer_heap), std::greater<> {});
+
+      return seq;
+    }
+
+    bool is_stale(const timer_entry_t &entry) const {
+      auto it = _timer_tasks.find(entry.task_id);
+
+      // A task that ran or was cancelled may share its ID with a newer task
+      return it == std::end(_timer_tasks) || it->second.seq != entry.seq;
+    }
+
+    // Drop stale entries from the top of the heap, and return the earliest valid one
+    const timer_entry_t *next_timer_entry() {
+      while (!_timer_heap.empty() && is_stale(_timer_heap.front())) {
+        std::pop_heap(std::begin(_timer_heap), std::end(_timer_heap), std::greater<> {});
+        _timer_heap.pop_back();
+      }
+
+      return _timer_heap.empty() ? nullptr : &_timer_heap.front();
+    }
+
+    // Rebuild the heap once stale entries outnumber the tasks, so constant cancelling and
+    // rescheduling doesn't let it grow without bounds
+    void compact_timer_heap() {
+      if (_timer_heap.size() <= 2 * _timer_tasks.size() + 64) {
+        return;
+      }
+
+      std::erase_if(_timer_heap, [this](const timer_entry_t &entry) {
+        return is_stale(entry);
+      });
+      std::make_heap(std::begin(_timer_heap), std::end(_timer_heap), std::greater<> {});
+    }
+
+  protected:
+    /**
+     * @brief Wrap a callable into a task owned by the pool.
+     *
+     * @param f Callable executed when the task runs.
+     * @return Type-erased task.
+     */
     template<class Function>
     std::unique_ptr<_ImplBase> toRunnable(Function &&f) {
       return std::make_unique<_Impl<Function>>(std::forward<Function &&>(f));
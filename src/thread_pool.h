@@ -5,15 +5,26 @@
 #pragma once
 
 // standard includes
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
 #include <thread>
 
 // local includes
 #include "platform/common.h"
 #include "task_pool.h"
+#include "utility.h"
 
 namespace thread_pool_util {
   /**
    * Allow threads to execute unhindered while keeping full control over the threads.
+   *
+   * Every task waits in a single queue and runs on the first worker that is free. Delayed
+   * tasks are kept by the TaskPool under their own lock, and run by whichever worker notices
+   * they're due.
    */
   class ThreadPool: public task_pool_util::TaskPool {
   public:
@@ -25,10 +36,23 @@ namespace thread_pool_util {
   private:
     std::vector<std::jthread> _thread;
 
+    // Immediate tasks, in the order they were pushed
+    std::deque<__task> _queue;
+    std::mutex _queue_lock;
+
+    // Immediate tasks pushed but not yet taken by a worker
+    std::atomic<std::int64_t> _pending {0};
+
+    // Due time of the earliest delayed task, as a steady_clock tick count
+    std::atomic<__time_point::rep> _timer_due {std::numeric_limits<__time_point::rep>::max()};
+    std::mutex _timer_lock;
+
+    // Idle workers sleep on _cv, pushes only take _lock when one of them may be asleep
     std::condition_variable _cv;
     std::mutex _lock;
+    std::atomic_int _sleepers {0};
 
-    bool _continue;
+    std::atomic_bool _continue;
 
   public:
     ThreadPool():
@@ -41,11 +65,8 @@ namespace thread_pool_util {
      * @param threads Number of worker threads to start.
      */
     explicit ThreadPool(int threads):
-        _thread(threads),
-        _continue {true} {
-      for (auto &t : _thread) {
-        t = std::jthread(&ThreadPool::_main, this);
-      }
+        ThreadPool() {
+      start(threads);
     }
 
     ~ThreadPool() noexcept {
@@ -66,10 +87,34 @@ namespace thread_pool_util {
      */
     template<class Function, class... Args>
     auto push(Function &&newTask, Args &&...args) {
-      std::lock_guard lg(_lock);
-      auto future = TaskPool::push(std::forward<Function>(newTask), std::forward<Args>(args)...);
+      static_assert(std::is_invocable_v<Function, Args &&...>, "arguments don't match the function");
+
+      using __return = std::invoke_result_t<Function, Args &&...>;
+      using task_t = std::packaged_task<__return()>;
+
+      auto bind = [task = std::forward<Function>(newTask), tuple_args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+        return std::apply(task, std::move(tuple_args));
+      };
+
+      task_t task(std::move(bind));
+
+      auto future = task.get_future();
+      auto runnable = toRunnable(std::move(task));
+
+      // Counted first, so it never drops below the number of queued tasks
+      _pending.fetch_add(1);
+
+      {
+        std::lock_guard lg {_queue_lock};
+        _queue.emplace_back(std::move(runnable));
+      }
+
+      // Either a sleeping worker saw the new count, or this sees the sleeping worker
+      if (_sleepers.load() > 0) {
+        std::lock_guard lg {_lock};
+        _cv.notify_one();
+      }
 
-      _cv.notify_one();
       return future;
     }
 
@@ -79,9 +124,15 @@ namespace thread_pool_util {
      * @param task Task object to enqueue or execute.
      */
     void pushDelayed(std::pair<__time_point, __task> &&task) {
-      std::lock_guard lg(_lock);
+      auto time_point = task.first;
+      {
+        std::lock_guard lg(_timer_lock);
 
-      TaskPool::pushDelayed(std::move(task));
+        TaskPool::pushDelayed(std::move(task));
+        lower_timer_due(time_point);
+      }
+
+      notify_timers();
     }
 
     /**
@@ -94,14 +145,43 @@ namespace thread_pool_util {
      */
     template<class Function, class X, class Y, class... Args>
     auto pushDelayed(Function &&newTask, std::chrono::duration<X, Y> duration, Args &&...args) {
-      std::lock_guard lg(_lock);
+      std::unique_lock ul(_timer_lock);
       auto future = TaskPool::pushDelayed(std::forward<Function>(newTask), duration, std::forward<Args>(args)...);
+      lower_timer_due(*TaskPool::next());
+      ul.unlock();
 
       // Update all timers for wait_until
-      _cv.notify_all();
+      notify_timers();
       return future;
     }
 
+    /**
+     * @param task_id The id of the task to delay.
+     * @param duration The delay before executing the task.
+     */
+    template<class X, class Y>
+    void delay(task_id_t task_id, std::chrono::duration<X, Y> duration) {
+      {
+        std::lock_guard lg(_timer_lock);
+
+        TaskPool::delay(task_id, duration);
+        refresh_timer_due();
+      }
+
+      notify_timers();
+    }
+
+    /**
+     * @brief Cancel a delayed task before it runs.
+     *
+     * @param task_id Identifier returned when the task was queued.
+     * @return True when the task was found and cancelled.
+     */
+    bool cancel(task_id_t task_id) {
+      // Workers that wake up for a cancelled task find nothing and look again
+      return TaskPool::cancel(task_id);
+    }
+
     /**
      * @brief Start worker threads for queued thread-pool tasks.
      *
@@ -142,7 +222,6 @@ namespace thread_pool_util {
      * @return True while the thread pool is running.
      */
     bool running() {
-      std::lock_guard lg(_lock);
       return _continue;
     }
 
@@ -152,32 +231,104 @@ namespace thread_pool_util {
      */
     void _main() {
       platf::set_thread_name("TaskPool::worker");
+
       while (_continue) {
-        if (auto task = this->pop()) {
+        if (auto task = take()) {
           (*task)->run();
         } else {
-          std::unique_lock uniq_lock(_lock);
-
-          if (ready()) {
-            continue;
-          }
-
-          if (!_continue) {
-            break;
-          }
-
-          if (auto tp = next()) {
-            _cv.wait_until(uniq_lock, *tp);
-          } else {
-            _cv.wait(uniq_lock);
-          }
+          idle();
         }
       }
 
       // Execute remaining tasks
-      while (auto task = this->pop()) {
+      while (auto task = take()) {
         (*task)->run();
       }
     }
+
+  private:
+    /**
+     * @brief Find the next task for a worker, due delayed tasks first.
+     *
+     * @return Task to run, or std::nullopt if none was found.
+     */
+    std::optional<__task> take() {
+      auto due = _timer_due.load(std::memory_order_relaxed);
+      if (due != std::numeric_limits<__time_point::rep>::max() && std::chrono::steady_clock::now().time_since_epoch().count() >= due) {
+        if (auto task = take_timer()) {
+          return task;
+        }
+      }
+
+      std::lock_guard lg {_queue_lock};
+
+      if (_queue.empty()) {
+        return std::nullopt;
+      }
+
+      auto task = std::move(_queue.front());
+      _queue.pop_front();
+      _pending.fetch_sub(1);
+
+      return task;
+    }
+
+    std::optional<__task> take_timer() {
+      std::lock_guard lg {_timer_lock};
+
+      auto task = TaskPool::pop();
+      refresh_timer_due();
+
+      return task;
+    }
+
+    /**
+     * @brief Wait for new tasks, until the next delayed task is due.
+     */
+    void idle() {
+      std::unique_lock ul {_lock};
+
+      _sleepers.fetch_add(1);
+      auto fg = util::fail_guard([this]() {
+        _sleepers.fetch_sub(1);
+      });
+
+      if (!_continue) {
+        return;
+      }
+
+      // A pushed task was counted, but hasn't been taken yet
+      if (_pending.load() > 0) {
+        ul.unlock();
+        std::this_thread::yield();
+
+        return;
+      }
+
+      auto due = _timer_due.load();
+      if (due == std::numeric_limits<__time_point::rep>::max()) {
+        _cv.wait(ul);
+      } else {
+        _cv.wait_until(ul, __time_point {__time_point::duration {due}});
+      }
+    }
+
+    // Must be called with _timer_lock held
+    void lower_timer_due(__time_point time_point) {
+      if (time_point.time_since_epoch().count() < _timer_due.load()) {
+        _timer_due.store(time_point.time_since_epoch().count());
+      }
+    }
+
+    // Must be called with _timer_lock held
+    void refresh_timer_due() {
+      auto next = TaskPool::next();
+      _timer_due.store(next ? next->time_since_epoch().count() : std::numeric_limits<__time_point::rep>::max());
+    }
+
+    void notify_timers() {
+      std::lock_guard lg {_lock};
+      _cv.notify_all();
+    }
   };
 }  // namespace thread_pool_util
@@ -5,12 +5,18 @@
 #pragma once
 
 // standard includes
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <ranges>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 // local includes
@@ -384,8 +390,29 @@ namespace safe {
     return std::make_shared<alarm_raw_t<T>>();
   }
 
+  /**
+   * @brief What a queue_t does with a new element when it is full.
+   */
+  enum class overflow_e {
+    drop_oldest,  ///< Drop the oldest queued element to make room.
+    drop_newest,  ///< Drop the new element.
+    block,  ///< Wait until a consumer makes room, or the queue is stopped.
+  };
+
+  /**
+   * @brief Counters of a queue_t.
+   */
+  struct queue_stats_t {
+    std::size_t high_water;  ///< Most elements that were queued at once.
+    std::uint64_t overflows;  ///< Elements raised while the queue was full.
+    std::uint64_t dropped;  ///< Elements dropped because the queue was full.
+  };
+
   /**
    * @brief Thread-safe queue with blocking and shutdown-aware consumers.
+   *
+   * Elements are kept in a fixed-capacity ring, what happens when it is full depends on
+   * the overflow policy of the queue.
    */
   template<class T>
   class queue_t {
@@ -398,10 +425,12 @@ namespace safe {
     /**
      * @brief Construct a bounded blocking queue.
      *
-     * @param max_elements Maximum number of queued elements before producers block.
+     * @param max_elements Maximum number of queued elements.
+     * @param overflow What to do with new elements while the queue is full.
      */
-    queue_t(std::uint32_t max_elements = 32):
-        _max_elements {max_elements} {
+    queue_t(std::uint32_t max_elements = 32, overflow_e overflow = overflow_e::drop_oldest):
+        _overflow {overflow},
+        _ring(std::max<std::uint32_t>(max_elements, 1)) {
     }
 
     /**
@@ -411,17 +440,37 @@ namespace safe {
      */
     template<class... Args>
     void raise(Args &&...args) {
-      std::lock_guard ul {_lock};
+      std::unique_lock ul {_lock};
 
       if (!_continue) {
         return;
       }
 
-      if (_queue.size() == _max_elements) {
-        _queue.clear();
+      if (_size == _ring.size()) {
+        ++_overflows;
+
+        switch (_overflow) {
+          case overflow_e::drop_oldest:
+            ++_dropped;
+            take_front();
+            break;
+          case overflow_e::drop_newest:
+            ++_dropped;
+            return;
+          case overflow_e::block:
+            _not_full.wait(ul, [this]() {
+              return !_continue || _size < _ring.size();
+            });
+
+            if (!_continue) {
+              return;
+            }
+            break;
+        }
       }
 
-      _queue.emplace_back(std::forward<Args>(args)...);
+      _ring[(_head + _size) % _ring.size()].emplace(std::forward<Args>(args)...);
+      _high_water = std::max(_high_water, ++_size);
 
       _cv.notify_all();
     }
@@ -432,7 +481,7 @@ namespace safe {
      * @return True when a value is available to inspect.
      */
     bool peek() {
-      return _continue && !_queue.empty();
+      return _continue && _size > 0;
     }
 
     /**
@@ -449,16 +498,13 @@ namespace safe {
         return util::false_v<status_t>;
       }
 
-      while (_queue.empty()) {
+      while (_size == 0) {
         if (!_continue || _cv.wait_for(ul, delay) == std::cv_status::timeout) {
           return util::false_v<status_t>;
         }
       }
 
-      auto val = std::move(_queue.front());
-      _queue.erase(std::begin(_queue));
-
-      return val;
+      return take_front();
     }
 
     /**
@@ -473,7 +519,7 @@ namespace safe {
         return util::false_v<status_t>;
       }
 
-      while (_queue.empty()) {
+      while (_size == 0) {
         _cv.wait(ul);
 
         if (!_continue) {
@@ -481,19 +527,60 @@ namespace safe {
         }
       }
 
-      auto val = std::move(_queue.front());
-      _queue.erase(std::begin(_queue));
+      return take_front();
+    }
 
-      return val;
+    /**
+     * @brief Return the number of queued elements.
+     *
+     * @return Elements waiting to be popped.
+     */
+    std::size_t size() {
+      std::lock_guard lg {_lock};
+
+      return _size;
+    }
+
+    /**
+     * @brief Return the number of queued elements matching a predicate.
+     *
+     * @param pred Called with each queued element, oldest first, while the queue is locked.
+     * @return Elements waiting to be popped for which `pred` returned `true`.
+     */
+    template<class Pred>
+    std::size_t count_if(Pred &&pred) {
+      std::lock_guard lg {_lock};
+
+      std::size_t count = 0;
+      for (std::size_t x = 0; x < _size; ++x) {
+        if (pred(std::as_const(*_ring[(_head + x) % _ring.size()]))) {
+          ++count;
+        }
+      }
+
+      return count;
+    }
+
+    /**
+     * @brief Counters since the queue was created.
+     *
+     * @return Queue statistics.
+     */
+    queue_stats_t stats() {
+      std::lock_guard lg {_lock};
+
+      return {_high_water, _overflows, _dropped};
     }
 
     /**
-     * @brief Return the wrapped pointer without synchronization checks.
+     * @brief Return the queued elements without synchronization checks.
      *
-     * @return Mutable queue storage for callers that already hold external synchronization.
+     * @return Range over the queued elements, oldest first, for callers that already hold external synchronization.
      */
-    std::vector<T> &unsafe() {
-      return _queue;
+    auto unsafe() {
+      return std::views::iota(std::size_t {0}, _size) | std::views::transform([this](std::size_t x) -> T & {
+               return *_ring[(_head + x) % _ring.size()];
+             });
     }
 
     /**
@@ -505,6 +592,7 @@ namespace safe {
       _continue = false;
 
       _cv.notify_all();
+      _not_full.notify_all();
     }
 
     /**
@@ -517,13 +605,205 @@ namespace safe {
     }
 
   private:
+    // Must be called with _lock held and at least one element queued
+    T take_front() {
+      auto &slot = _ring[_head];
+      auto val = std::move(*slot);
+      slot.reset();
+
+      _head = (_head + 1) % _ring.size();
+      --_size;
+
+      _not_full.notify_one();
+
+      return val;
+    }
+
     bool _continue {true};
-    std::uint32_t _max_elements;
+    overflow_e _overflow;
 
     std::mutex _lock;
     std::condition_variable _cv;
+    std::condition_variable _not_full;
+
+    std::vector<std::optional<T>> _ring;
+    std::size_t _head = 0;
+    std::size_t _size = 0;
+
+    std::size_t _high_water = 0;
+    std::uint64_t _overflows = 0;
+    std::uint64_t _dropped = 0;
+  };
+
+  template<class T>
+  class pool_t;
+
+  /**
+   * @brief Object borrowed from a pool_t, given back to it when destroyed.
+   *
+   * The pool stays alive as long as any of its objects are borrowed, so objects may be
+   * passed to other threads and outlive the code that owns the pool.
+   */
+  template<class T>
+  class pooled_t {
+  public:
+    pooled_t() = default;
+
+    /**
+     * @brief Wrap an object that is given back to a pool.
+     *
+     * @param pool Pool the object is given back to.
+     * @param value Borrowed object.
+     */
+    pooled_t(std::shared_ptr<pool_t<T>> pool, T &&value):
+        _pool {std::move(pool)},
+        _value {std::move(value)} {
+    }
+
+    pooled_t(pooled_t &&) noexcept = default;
+
+    /**
+     * @brief Swap the borrowed object with another one, both are given back when destroyed.
+     *
+     * @param other Object to swap with.
+     * @return This object.
+     */
+    pooled_t &operator=(pooled_t &&other) noexcept {
+      std::swap(_pool, other._pool);
+      std::swap(_value, other._value);
+
+      return *this;
+    }
+
+    ~pooled_t() {
+      if (_pool) {
+        _pool->release(std::move(_value));
+      }
+    }
+
+    /**
+     * @brief Access the borrowed object.
+     *
+     * @return Reference to the borrowed object.
+     */
+    T &operator*() {
+      return _value;
+    }
+
+    /**
+     * @brief Access the borrowed object.
+     *
+     * @return Const reference to the borrowed object.
+     */
+    const T &operator*() const {
+      return _value;
+    }
+
+    /**
+     * @brief Access members of the borrowed object.
+     *
+     * @return Pointer to the borrowed object.
+     */
+    T *operator->() {
+      return &_value;
+    }
+
+    /**
+     * @brief Access members of the borrowed object.
+     *
+     * @return Const pointer to the borrowed object.
+     */
+    const T *operator->() const {
+      return &_value;
+    }
+
+    /**
+     * @brief Pool the object is given back to.
+     *
+     * @return Owning pool, or nullptr if nothing is borrowed.
+     */
+    const std::shared_ptr<pool_t<T>> &pool() const {
+      return _pool;
+    }
 
-    std::vector<T> _queue;
+  private:
+    std::shared_ptr<pool_t<T>> _pool;
+    T _value;
+  };
+
+  /**
+   * @brief Thread-safe pool that recycles objects instead of allocating new ones.
+   *
+   * Objects are created by a factory when the pool runs dry and kept for reuse when they
+   * are given back, up to a fixed number. Once enough objects circulate between the
+   * threads that use them, borrowing and giving back no longer allocates.
+   */
+  template<class T>
+  class pool_t: public std::enable_shared_from_this<pool_t<T>> {
+  public:
+    /**
+     * @brief Create a pool.
+     *
+     * @param factory Creates a new object when no free one is left.
+     * @param max_free Free objects kept for reuse, extra objects given back are destroyed.
+     * @return Shared pool.
+     */
+    static std::shared_ptr<pool_t> make(std::function<T()> factory, std::size_t max_free) {
+      return std::shared_ptr<pool_t>(new pool_t {std::move(factory), max_free});
+    }
+
+    /**
+     * @brief Borrow an object, creating it if no free one is left.
+     *
+     * @return Borrowed object, in the state it was given back in.
+     */
+    pooled_t<T> acquire() {
+      {
+        std::lock_guard lg {_lock};
+        if (!_free.empty()) {
+          auto value = std::move(_free.back());
+          _free.pop_back();
+
+          return {this->shared_from_this(), std::move(value)};
+        }
+      }
+
+      ++_allocations;
+      return {this->shared_from_this(), _factory()};
+    }
+
+    /**
+     * @brief Number of objects created by the factory.
+     *
+     * @return Objects created since the pool was made.
+     */
+    std::uint64_t allocations() const {
+      return _allocations;
+    }
+
+  private:
+    friend class pooled_t<T>;
+
+    pool_t(std::function<T()> &&factory, std::size_t max_free):
+        _factory {std::move(factory)},
+        _max_free {max_free} {
+      // Giving an object back must not allocate either
+      _free.reserve(max_free);
+    }
+
+    void release(T &&value) {
+      std::lock_guard lg {_lock};
+      if (_free.size() < _max_free) {
+        _free.emplace_back(std::move(value));
+      }
+    }
+
+    std::function<T()> _factory;
+    std::size_t _max_free;
+    std::atomic<std::uint64_t> _allocations {0};
+
+    std::mutex _lock;
+    std::vector<T> _free;
   };
 
   /**
@@ -730,6 +1010,36 @@ namespace safe {
    */
   using signal_t = event_t<bool>;
 
+  /**
+   * @brief Channel of a mailbox, numbered at compile time.
+   *
+   * Every mailbox keeps the channel at the same index, so it is found without hashing or
+   * comparing its name.
+   */
+  struct mail_id_t {
+    std::size_t index;  ///< Index of the channel in every mailbox.
+    std::string_view name;  ///< Name of the channel.
+
+    /**
+     * @brief Name of the channel, for code that still refers to channels by name.
+     */
+    constexpr operator std::string_view() const {
+      return name;
+    }
+  };
+
+  /**
+   * @brief Mailbox channel carrying events of type T.
+   */
+  template<class T>
+  struct event_id_t: mail_id_t {};
+
+  /**
+   * @brief Mailbox channel carrying a queue of type T.
+   */
+  template<class T>
+  struct queue_id_t: mail_id_t {};
+
   class mail_raw_t;
   /**
    * @brief Shared mailbox handle used by event and queue wrappers.
@@ -762,9 +1072,13 @@ namespace safe {
     }
 
     mail_t mail;  ///< Mailbox kept alive until the posted object is destroyed.
+    bool named = false;  ///< Looked up by name, and removed from the map of the mailbox when destroyed.
 
     ~post_t() {
-      cleanup(mail.get());
+      // Channels with a declared id expire in their slot, without locking the mailbox
+      if (named) {
+        cleanup(mail.get());
+      }
     }
   };
 
@@ -796,9 +1110,56 @@ namespace safe {
     template<class T>
     using queue_t = std::shared_ptr<post_t<queue_t<T>>>;
 
+    /**
+     * @brief Maximum number of channels declared with an index.
+     */
+    static constexpr std::size_t MAX_IDS = 32;
+
+    /**
+     * @brief Get the event channel with the given id, creating it if nobody holds it.
+     *
+     * @param id Channel declared with MAIL().
+     * @return Typed event channel associated with the supplied identifier.
+     */
+    template<class T>
+    event_t<T> event(const event_id_t<T> &id) {
+      return get<event_t<T>>(id, [this]() {
+        return std::make_shared<typename event_t<T>::element_type>(shared_from_this());
+      });
+    }
+
+    /**
+     * @brief Get the queue channel with the given id, creating it if nobody holds it.
+     *
+     * @param id Channel declared with MAIL().
+     * @return Typed queue channel associated with the supplied identifier.
+     */
+    template<class T>
+    queue_t<T> queue(const queue_id_t<T> &id) {
+      return get<queue_t<T>>(id, [this]() {
+        return std::make_shared<typename queue_t<T>::element_type>(shared_from_this(), 32);
+      });
+    }
+
+    /**
+     * @brief Asking for a channel with another payload type than it was declared with.
+     */
+    template<class T, class U>
+      requires(!std::is_same_v<T, U>)
+    event_t<T> event(const event_id_t<U> &id) = delete;
+
+    /**
+     * @brief Asking for a channel with another payload type than it was declared with.
+     */
+    template<class T, class U>
+      requires(!std::is_same_v<T, U>)
+    queue_t<T> queue(const queue_id_t<U> &id) = delete;
+
     /**
      * @brief Create a typed event channel from the raw mailbox.
      *
+     * Channels without a declared id are looked up by name, under a mutex shared by the mailbox.
+     *
      * @param id Identifier for the controller, session, display, or resource.
      * @return Typed event channel associated with the supplied identifier.
      */
@@ -812,6 +1173,7 @@ namespace safe {
       }
 
       auto post = std::make_shared<typename event_t<T>::element_type>(shared_from_this());
+      post->named = true;
       id_to_post.emplace(std::pair<std::string, std::weak_ptr<void>> {std::string {id}, post});
 
       return post;
@@ -820,6 +1182,8 @@ namespace safe {
     /**
      * @brief Create a typed queue channel from the raw mailbox.
      *
+     * Channels without a declared id are looked up by name, under a mutex shared by the mailbox.
+     *
      * @param id Identifier for the controller, session, display, or resource.
      * @return Typed queue channel associated with the supplied identifier.
      */
@@ -833,6 +1197,7 @@ namespace safe {
       }
 
       auto post = std::make_shared<typename queue_t<T>::element_type>(shared_from_this(), 32);
+      post->named = true;
       id_to_post.emplace(std::pair<std::string, std::weak_ptr<void>> {std::string {id}, post});
 
       return post;
@@ -858,6 +1223,35 @@ namespace safe {
     std::mutex mutex;  ///< Mutex protecting the map of live posted objects.
 
     std::map<std::string, std::weak_ptr<void>, std::less<>> id_to_post;  ///< Posted objects keyed by cleanup identifier.
+
+  private:
+    /**
+     * @brief Channel with a declared id.
+     */
+    struct slot_t {
+      std::mutex lock;  ///< Held while post is read or replaced.
+      std::weak_ptr<void> post;  ///< The channel, for as long as somebody holds it.
+    };
+
+    template<class T, class F>
+    T get(const mail_id_t &id, F &&make) {
+      auto &slot = slots[id.index];
+
+      // Not lock-free, but channels don't contend with each other, and the lock is only held
+      // for as long as it takes to copy a pointer, or to create a missing channel
+      std::lock_guard lg {slot.lock};
+
+      if (auto post = lock<T>(slot.post)) {
+        return post;
+      }
+
+      T post = make();
+      slot.post = post;
+
+      return post;
+    }
+
+    std::array<slot_t, MAX_IDS> slots;
   };
 
   /**
@@ -14,6 +14,7 @@
 #include "confighttp.h"
 #include "globals.h"
 #include "logging.h"
+#include "mail.h"
 #include "network.h"
 #include "nvhttp.h"
 #include "rtsp.h"
@@ -31,6 +31,7 @@ extern "C" {
 #include "globals.h"
 #include "input.h"
 #include "logging.h"
+#include "mail.h"
 #include "nvenc/nvenc_encoder.h"
 #include "platform/common.h"
 #include "sync.h"
@@ -502,6 +503,39 @@ namespace video {
       request_idr_frame();
     }
 
+    /**
+     * @brief Update the rate control fields of the codec context.
+     *
+     * libx264, NVENC and QSV compare these fields before each frame and reconfigure
+     * themselves. Other FFmpeg encoders ignore changes, so they must be reopened.
+     *
+     * @param bitrate_kbps New bitrate in kilobits per second.
+     * @return `true` if the encoder picks up the bitrate with the next frame.
+     */
+    bool set_bitrate(int bitrate_kbps) override {
+      std::string_view name = avcodec_ctx->codec->name;
+      if (name != "libx264"sv && !name.ends_with("_nvenc"sv) && !name.ends_with("_qsv"sv)) {
+        return false;
+      }
+
+      auto ctx = avcodec_ctx.get();
+      auto bitrate = (int64_t) bitrate_kbps * 1000;
+
+      // Keep the same number of frames in the rate control buffer
+      if (ctx->rc_buffer_size > 0 && ctx->rc_max_rate > 0) {
+        ctx->rc_buffer_size = (int) (ctx->rc_buffer_size * bitrate / ctx->rc_max_rate);
+      }
+
+      // Preserve the rate control mode chosen when the encoder was opened
+      if (ctx->rc_min_rate == ctx->rc_max_rate) {
+        ctx->rc_min_rate = bitrate;
+      }
+      ctx->bit_rate = ctx->bit_rate < ctx->rc_max_rate ? bitrate - 1 : bitrate;
+      ctx->rc_max_rate = bitrate;
+
+      return true;
+    }
+
     avcodec_ctx_t avcodec_ctx;  ///< FFmpeg codec context owned by the encode session.
     std::unique_ptr<platf::avcodec_encode_device_t> device;  ///< Platform device used by the FFmpeg hardware encoder.
 
@@ -571,6 +605,20 @@ namespace video {
       }
     }
 
+    /**
+     * @brief Change the average bitrate of the NVENC session.
+     *
+     * @param bitrate_kbps New bitrate in kilobits per second.
+     * @return `true` if NVENC was reconfigured.
+     */
+    bool set_bitrate(int bitrate_kbps) override {
+      if (!device || !device->nvenc) {
+        return false;
+      }
+
+      return device->nvenc->set_bitrate(bitrate_kbps);
+    }
+
     /**
      * @brief Submit the next frame to NVENC and return the encoded payload.
      *
@@ -600,6 +648,7 @@ namespace video {
     safe::mail_raw_t::event_t<bool> shutdown_event;  ///< Event raised when the stream should shut down.
     safe::mail_raw_t::queue_t<packet_t> packets;  ///< Queue receiving encoded video packets for the stream sender.
     safe::mail_raw_t::event_t<bool> idr_events;  ///< Event raised when an IDR frame is requested.
+    safe::mail_raw_t::event_t<int> bitrate_events;  ///< Event carrying a new target bitrate in kbps.
     safe::mail_raw_t::event_t<hdr_info_t> hdr_events;  ///< Event carrying updated HDR metadata.
     safe::mail_raw_t::event_t<input::touch_port_t> touch_port_events;  ///< Event carrying updated touch viewport metadata.
 
@@ -649,7 +698,7 @@ namespace video {
    * @brief Synchronous capture thread state.
    */
   struct capture_thread_sync_ctx_t {
-    encode_session_ctx_queue_t encode_session_ctx_queue {30};  ///< Encode session ctx queue.
+    encode_session_ctx_queue_t encode_session_ctx_queue {30, safe::overflow_e::block};  ///< Encode session ctx queue.
   };
 
   /**
@@ -678,6 +727,15 @@ namespace video {
    * @param ctx Native context object used by the operation or callback.
    */
   void end_capture_async(capture_thread_async_ctx_t &ctx);
+  /**
+   * @brief Create encode device.
+   *
+   * @param disp Display connection or display handle.
+   * @param encoder Encoder configuration or encoder instance.
+   * @param config Configuration values to apply.
+   * @return Constructed encode device object.
+   */
+  std::unique_ptr<platf::encode_device_t> make_encode_device(platf::display_t &disp, const encoder_t &encoder, const config_t &config);
 
   // Keep a reference counter to ensure the capture thread only runs when other threads have a reference to the capture thread
   auto capture_thread_async = safe::make_shared<capture_thread_async_ctx_t>(start_capture_async, end_capture_async);  ///< Capture thread async.
@@ -2348,7 +2406,7 @@ namespace video {
     int &frame_nr,  // Store progress of the frame number
     safe::mail_t mail,
     img_event_t images,
-    config_t config,
+    config_t &config,
     std::shared_ptr<platf::display_t> disp,
     std::unique_ptr<platf::encode_device_t> encode_device,
     safe::signal_t &reinit_event,
@@ -2386,16 +2444,18 @@ namespace video {
     auto packets = mail::man->queue<packet_t>(mail::video_packets);
     auto idr_events = mail->event<bool>(mail::idr);
     auto invalidate_ref_frames_events = mail->event<std::pair<int64_t, int64_t>>(mail::invalidate_ref_frames);
+    auto bitrate_events = mail->event<int>(mail::bitrate);
 
-    {
-      // Load a dummy image into the AVFrame to ensure we have something to encode
-      // even if we timeout waiting on the first frame. This is a relatively large
-      // allocation which can be freed immediately after convert(), so we do this
-      // in a separate scope.
+    // Load a dummy image into the AVFrame to ensure we have something to encode
+    // even if we timeout waiting on the first frame. This is a relatively large
+    // allocation which can be freed immediately after convert(), so it is not kept.
+    auto convert_dummy_img = [&]() {
       auto dummy_img = disp->alloc_img();
-      if (!dummy_img || disp->dummy_img(dummy_img.get()) || session->convert(*dummy_img)) {
-        return;
-      }
+      return dummy_img && !disp->dummy_img(dummy_img.get()) && !session->convert(*dummy_img);
+    };
+
+    if (!convert_dummy_img()) {
+      return;
     }
 
     while (true) {
@@ -2412,6 +2472,31 @@ namespace video {
         idr_events->pop();
       }
 
+      if (bitrate_events->peek()) {
+        config.bitrate = *bitrate_events->pop();
+
+        if (session->set_bitrate(config.bitrate)) {
+          BOOST_LOG(debug) << "Encoder bitrate changed to "sv << config.bitrate << " kbps"sv;
+        } else {
+          // Encoders that can't change their bitrate on the fly, such as libx265, are reopened
+          // for this session only. The display keeps capturing, and the new encoder starts with an IDR frame.
+          BOOST_LOG(info) << "Reopening encoder to change bitrate to "sv << config.bitrate << " kbps"sv;
+
+          // Close the old encoder first, hardware encoders may only allow a few sessions at once
+          session.reset();
+
+          auto new_device = make_encode_device(*disp, encoder, config);
+          if (!new_device) {
+            return;
+          }
+
+          session = make_encode_session(disp.get(), encoder, config, disp->width, disp->height, std::move(new_device));
+          if (!session || !convert_dummy_img()) {
+            return;
+          }
+        }
+      }
+
       if (requested_idr_frame) {
         session->request_idr_frame();
       }
@@ -2726,6 +2811,26 @@ namespace video {
             ctx->idr_events->pop();
           }
 
+          if (ctx->bitrate_events->peek()) {
+            ctx->config.bitrate = *ctx->bitrate_events->pop();
+
+            if (pos->session->set_bitrate(ctx->config.bitrate)) {
+              BOOST_LOG(debug) << "Encoder bitrate changed to "sv << ctx->config.bitrate << " kbps"sv;
+            } else {
+              // The encoder can't change its bitrate on the fly, so reopen it
+              BOOST_LOG(info) << "Reopening encoder to change bitrate to "sv << ctx->config.bitrate << " kbps"sv;
+              pos->session.reset();
+
+              auto encode_session = make_synced_session(disp.get(), encoder, *img, *ctx);
+              if (!encode_session) {
+                ctx->shutdown_event->raise(true);
+
+                continue;
+              }
+              pos->session = std::move(encode_session->session);
+            }
+          }
+
           if (frame_captured && pos->session->convert(*img)) {
             BOOST_LOG(error) << "Could not convert image"sv;
             ctx->shutdown_event->raise(true);
@@ -2926,6 +3031,7 @@ namespace video {
         mail->event<bool>(mail::shutdown),
         mail::man->queue<packet_t>(mail::video_packets),
         std::move(idr_events),
+        mail->event<int>(mail::bitrate),
         mail->event<hdr_info_t>(mail::hdr),
         mail->event<input::touch_port_t>(mail::touch_port),
         config,
@@ -3597,7 +3703,8 @@ namespace video {
     capture_thread_ctx.encoder_p = chosen_encoder;
     capture_thread_ctx.reinit_event.reset();
 
-    capture_thread_ctx.capture_ctx_queue = std::make_shared<safe::queue_t<capture_ctx_t>>(30);
+    // A session whose context is dropped would wait for frames forever
+    capture_thread_ctx.capture_ctx_queue = std::make_shared<safe::queue_t<capture_ctx_t>>(30, safe::overflow_e::block);
 
     capture_thread_ctx.capture_thread = std::jthread {
       captureThread,
@@ -449,6 +449,14 @@ namespace video {
      * @param last_frame Last frame.
      */
     virtual void invalidate_ref_frames(int64_t first_frame, int64_t last_frame) = 0;
+
+    /**
+     * @brief Change the target bitrate of the running encoder.
+     *
+     * @param bitrate_kbps New bitrate in kilobits per second.
+     * @return `true` if the encoder applies the bitrate without being reopened.
+     */
+    virtual bool set_bitrate(int bitrate_kbps) = 0;
   };
 
   // encoders
@@ -0,0 +1,67 @@
+/**
+ * @file tests/benchmarks/bench_gf256.cpp
+ * @brief Benchmark src/gf256.*.
+ */
+#include "../tests_common.h"
+
+// standard includes
+#include <chrono>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+// lib includes
+#include <rs.h>
+
+// local includes
+#include <src/gf256.h>
+
+using gf256::kernel_e;
+
+class GF256Benchmark: public testing::TestWithParam<kernel_e> {
+protected:
+  void SetUp() override {
+    if (!gf256::supported(GetParam())) {
+      GTEST_SKIP() << gf256::to_string(GetParam()) << " is not supported on this CPU";
+    }
+  }
+};
+
+INSTANTIATE_TEST_SUITE_P(
+  Kernels,
+  GF256Benchmark,
+  testing::Values(kernel_e::scalar, kernel_e::ssse3, kernel_e::avx2, kernel_e::avx512, kernel_e::neon),
+  [](const auto &info) {
+    std::string name {gf256::to_string(info.param)};
+    std::erase(name, '-');
+    return name;
+  }
+);
+
+TEST_P(GF256Benchmark, Encode) {
+  constexpr std::size_t blocksize = 1416;
+  constexpr auto iterations = 50;
+
+  reed_solomon_init();
+  for (auto [data_shards, parity_shards] : {std::pair {200, 40}, std::pair {100, 20}, std::pair {4, 2}}) {
+    auto rs = reed_solomon_new(data_shards, parity_shards);
+    ASSERT_NE(rs, nullptr);
+
+    std::vector<std::uint8_t> buffer((data_shards + parity_shards) * blocksize, 0x5A);
+    std::vector<std::uint8_t *> shards_p;
+    for (int x = 0; x < data_shards + parity_shards; ++x) {
+      shards_p.push_back(&buffer[x * blocksize]);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int x = 0; x < iterations; ++x) {
+      gf256::encode(GetParam(), rs->p, data_shards, parity_shards, shards_p.data(), blocksize);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    reed_solomon_release(rs);
+
+    auto bytes = (double) data_shards * blocksize * iterations;
+    std::cout << gf256::to_string(GetParam()) << ' ' << data_shards << '+' << parity_shards << " @ " << blocksize << ": "
+              << bytes / elapsed.count() / 1e9 << " GB/s" << std::endl;
+  }
+}
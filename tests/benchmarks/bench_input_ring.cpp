@@ -0,0 +1,127 @@
+/**
+ * @file tests/benchmarks/bench_input_ring.cpp
+ * @brief Benchmark src/input_ring.*.
+ */
+#include "../tests_common.h"
+
+// standard includes
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// local includes
+#include <src/input_ring.h>
+
+using namespace std::literals;
+using input_ring::latency_histogram_t;
+using input_ring::packet_t;
+using input_ring::ring_t;
+
+namespace {
+  /**
+   * @brief Send packets from a control thread to an input thread, and time how long each waits.
+   *
+   * @param push Queue a packet, returns `true` when the input thread must be woken up.
+   * @param drain Run every queued packet, returns the number of packets run.
+   */
+  template<class Push, class Drain>
+  void run_control_to_input(const char *name, Push &&push, Drain &&drain) {
+    constexpr int packets = 200'000;
+    constexpr int burst = 16;
+
+    latency_histogram_t latency;
+    std::atomic_int wakeups {0};
+
+    auto start = std::chrono::steady_clock::now();
+    std::jthread input([&]() {
+      int done = 0;
+      while (done < packets) {
+        auto woken = wakeups.load(std::memory_order_acquire);
+        done += drain(latency);
+        if (done < packets) {
+          wakeups.wait(woken, std::memory_order_acquire);
+        }
+      }
+    });
+
+    std::vector<std::uint8_t> packet(32);
+    for (int x = 0; x < packets; ++x) {
+      // Bursts of mouse motion, like a high polling rate mouse
+      if (x % burst == 0) {
+        std::this_thread::sleep_for(50us);
+      }
+
+      if (push(packet, std::chrono::steady_clock::now())) {
+        wakeups.fetch_add(1, std::memory_order_release);
+        wakeups.notify_one();
+      }
+    }
+    input.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << name << ": " << packets / elapsed.count() / 1e6 << " M packets/s, latency " << latency.to_string() << std::endl;
+  }
+}  // namespace
+
+TEST(InputRingBenchmark, ControlToInputThread) {
+  // One allocation and one wakeup per packet, as input used to be queued
+  {
+    std::mutex lock;
+    std::list<packet_t> queue;
+    std::atomic_int scheduled {0};
+
+    run_control_to_input(
+      "List, one task per packet",
+      [&](const std::vector<std::uint8_t> &data, input_ring::clock::time_point received) {
+        {
+          std::lock_guard lg {lock};
+          queue.push_back({data, received});
+        }
+        scheduled.fetch_add(1);
+        return true;
+      },
+      [&](latency_histogram_t &latency) {
+        int ran = 0;
+        while (scheduled.load() > 0) {
+          scheduled.fetch_sub(1);
+
+          std::lock_guard lg {lock};
+          latency.record(std::chrono::steady_clock::now() - queue.front().received);
+          queue.pop_front();
+          ++ran;
+        }
+
+        return ran;
+      }
+    );
+  }
+
+  {
+    ring_t ring;
+    std::vector<packet_t> batch;
+
+    run_control_to_input(
+      "Pooled ring, drained in batches",
+      [&](const std::vector<std::uint8_t> &data, input_ring::clock::time_point received) {
+        return ring.push(data, received);
+      },
+      [&](latency_histogram_t &latency) {
+        int ran = 0;
+        while (auto taken = ring.take(batch)) {
+          auto now = std::chrono::steady_clock::now();
+          for (std::size_t x = 0; x < taken; ++x) {
+            latency.record(now - batch[x].received);
+          }
+
+          ran += taken;
+        }
+
+        return ran;
+      }
+    );
+  }
+}
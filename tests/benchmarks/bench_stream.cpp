@@ -0,0 +1,95 @@
+/**
+ * @file tests/benchmarks/bench_stream.cpp
+ * @brief Benchmark src/stream.*.
+ */
+#include "../tests_common.h"
+
+// standard includes
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// lib includes
+#include <boost/asio.hpp>
+#include <moonlight-common-c/src/Limelight.h>
+
+// local includes
+#include <src/crypto.h>
+#include <src/rtsp.h>
+#include <src/stream.h>
+
+namespace {
+  /**
+   * @brief Read a recorded frame trace with one `timestamp_us,size,idr` line per frame.
+   */
+  std::vector<stream::testing::recorded_frame_t> read_recorded_frames(const std::string &path) {
+    std::vector<stream::testing::recorded_frame_t> frames;
+
+    std::ifstream in {path};
+    std::string line;
+    std::getline(in, line);  // Column names
+    while (std::getline(in, line)) {
+      long long timestamp;
+      std::size_t size;
+      int idr;
+      if (std::sscanf(line.c_str(), "%lld,%zu,%d", &timestamp, &size, &idr) == 3) {
+        frames.push_back({std::chrono::microseconds {timestamp}, size, idr != 0});
+      }
+    }
+
+    return frames;
+  }
+}  // namespace
+
+TEST(VideoReplayBenchmark, Throughput) {
+  auto frames = read_recorded_frames(SUNSHINE_SOURCE_DIR "/tests/fixtures/video/replay_1080p60_20mbps.csv");
+  ASSERT_FALSE(frames.empty());
+
+  boost::asio::io_context io;
+  boost::asio::ip::udp::socket sink {io, boost::asio::ip::udp::endpoint {boost::asio::ip::address_v4::loopback(), 0}};
+
+  auto run = [&](const char *name, std::uint32_t encryption_flags) {
+    stream::config_t config {};
+    config.monitor.width = 1920;
+    config.monitor.height = 1080;
+    config.monitor.framerate = 60;
+    config.monitor.bitrate = 25'000;
+    config.packetsize = 1392;
+    config.minRequiredFecPackets = 2;
+    config.encryptionFlagsEnabled = encryption_flags;
+
+    rtsp_stream::launch_session_t launch_session {};
+    launch_session.gcm_key = crypto::aes_t(16, 0x42);
+    launch_session.iv = crypto::aes_t(16, 0x24);
+
+    auto session = stream::session::alloc(config, launch_session);
+    auto stats = stream::testing::replay_video(*session, frames, sink.local_endpoint().port());
+    ASSERT_EQ(stats.frames, frames.size());
+
+    auto latencies = stats.frame_latencies;
+    std::sort(std::begin(latencies), std::end(latencies));
+    auto percentile = [&](int p) {
+      return std::chrono::duration<double, std::milli>(latencies[(latencies.size() - 1) * p / 100]).count();
+    };
+    auto seconds = [](std::chrono::nanoseconds duration) {
+      return std::chrono::duration<double>(duration).count();
+    };
+
+    auto duration = seconds(frames.back().timestamp) + 1. / config.monitor.framerate;
+    std::cout << name << ": "
+              << stats.bytes * 8 / duration / 1e6 << " Mbps, "
+              << stats.packets / duration << " packets/s, "
+              << "packetize " << seconds(stats.packetize_time) << " s, "
+              << "FEC " << seconds(stats.fec_time) << " s, "
+              << "encrypt " << seconds(stats.encrypt_time) << " s, "
+              << "send " << seconds(stats.send_time) << " s, "
+              << "frame latency p50 " << percentile(50) << " ms, p99 " << percentile(99) << " ms" << std::endl;
+  };
+
+  run("Encryption off", 0);
+  run("Encryption on", SS_ENC_VIDEO);
+}
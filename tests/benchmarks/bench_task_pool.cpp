@@ -0,0 +1,68 @@
+/**
+ * @file tests/benchmarks/bench_task_pool.cpp
+ * @brief Benchmark src/task_pool.h.
+ */
+#include "../tests_common.h"
+
+// standard includes
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+// local includes
+#include <src/task_pool.h>
+
+using namespace std::literals;
+using task_pool_util::TaskPool;
+
+TEST(TaskPoolBenchmark, DelayedTasks) {
+  constexpr int tasks = 100'000;
+
+  TaskPool pool;
+  std::mt19937 rng {42};
+  std::uniform_int_distribution<int> delay_us {0, 50'000};
+
+  int ran = 0;
+  std::vector<TaskPool::task_id_t> task_ids;
+  task_ids.reserve(tasks);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int x = 0; x < tasks; ++x) {
+    task_ids.push_back(pool.pushDelayed([&]() {
+      ++ran;
+    }, std::chrono::microseconds {delay_us(rng)}).task_id);
+  }
+  auto pushed = std::chrono::steady_clock::now();
+
+  // Cancel every other task, and push every cancelled one back as a new task
+  for (int x = 0; x < tasks; x += 2) {
+    ASSERT_TRUE(pool.cancel(task_ids[x]));
+    pool.pushDelayed([&]() {
+      ++ran;
+    }, std::chrono::microseconds {delay_us(rng)});
+  }
+  auto churned = std::chrono::steady_clock::now();
+
+  // Only the time spent popping counts, not the time waiting for tasks to be due
+  std::chrono::steady_clock::duration popping {};
+  while (auto next = pool.next()) {
+    std::this_thread::sleep_until(*next);
+
+    auto drain_start = std::chrono::steady_clock::now();
+    while (pool.ready()) {
+      (*pool.pop())->run();
+    }
+    popping += std::chrono::steady_clock::now() - drain_start;
+  }
+
+  EXPECT_EQ(ran, tasks);
+
+  auto ns_per_op = [](auto elapsed, int ops) {
+    return std::chrono::duration<double, std::nano>(elapsed).count() / ops;
+  };
+  std::cout << "pushDelayed: " << ns_per_op(pushed - start, tasks) << " ns" << std::endl;
+  std::cout << "cancel + pushDelayed: " << ns_per_op(churned - pushed, tasks / 2) << " ns" << std::endl;
+  std::cout << "pop: " << ns_per_op(popping, tasks) << " ns" << std::endl;
+}
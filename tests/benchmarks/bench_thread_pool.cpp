@@ -0,0 +1,81 @@
+/**
+ * @file tests/benchmarks/bench_thread_pool.cpp
+ * @brief Benchmark src/thread_pool.h.
+ */
+#include "../tests_common.h"
+
+// standard includes
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// local includes
+#include <src/thread_pool.h>
+
+using namespace std::literals;
+using thread_pool_util::ThreadPool;
+
+namespace {
+  /**
+   * @brief Push small tasks from several producers, and time how long each waits to run.
+   *
+   * Producers either push as fast as they can, or push bursts of tasks with a pause in
+   * between, like input packets arriving from several clients.
+   */
+  void run_multi_producer(const char *name, ThreadPool &pool, bool paced) {
+    constexpr int producers = 4;
+    constexpr int tasks_per_producer = 50'000;
+    constexpr int burst = 8;
+
+    std::vector<std::vector<std::chrono::nanoseconds>> latencies(producers);
+    std::atomic_int done {0};
+
+    auto start = std::chrono::steady_clock::now();
+    {
+      std::vector<std::jthread> threads;
+      for (int p = 0; p < producers; ++p) {
+        latencies[p].resize(tasks_per_producer);
+
+        threads.emplace_back([&, p]() {
+          for (int x = 0; x < tasks_per_producer; ++x) {
+            if (paced && x % burst == 0) {
+              std::this_thread::sleep_for(100us);
+            }
+
+            pool.push([&latency = latencies[p][x], &done, pushed = std::chrono::steady_clock::now()]() {
+              latency = std::chrono::steady_clock::now() - pushed;
+              done.fetch_add(1, std::memory_order_release);
+            });
+          }
+        });
+      }
+    }
+    while (done.load(std::memory_order_acquire) < producers * tasks_per_producer) {
+      std::this_thread::yield();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::vector<std::chrono::nanoseconds> all;
+    for (auto &producer : latencies) {
+      all.insert(std::end(all), std::begin(producer), std::end(producer));
+    }
+    std::sort(std::begin(all), std::end(all));
+
+    auto us = [](std::chrono::nanoseconds latency) {
+      return std::chrono::duration<double, std::micro>(latency).count();
+    };
+    std::cout << name << ": " << all.size() / elapsed.count() / 1e6 << " M tasks/s, latency p50 "
+              << us(all[all.size() / 2]) << " us, p99 " << us(all[all.size() * 99 / 100]) << " us, p99.9 "
+              << us(all[all.size() * 999 / 1000]) << " us" << std::endl;
+  }
+}  // namespace
+
+TEST(ThreadPoolBenchmark, MultiProducer) {
+  for (auto paced : {false, true}) {
+    ThreadPool pool {4};
+    run_multi_producer(paced ? "Paced" : "Saturated", pool, paced);
+  }
+}
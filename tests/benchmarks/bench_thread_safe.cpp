@@ -0,0 +1,55 @@
+/**
+ * @file tests/benchmarks/bench_thread_safe.cpp
+ * @brief Benchmark src/thread_safe.h.
+ */
+#include "../tests_common.h"
+
+// standard includes
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// local includes
+#include <src/thread_safe.h>
+
+using namespace std::literals;
+
+namespace {
+  constexpr safe::event_id_t<int> test_event {{0, "test_event"}};
+}  // namespace
+
+TEST(MailBenchmark, Lookup) {
+  constexpr int lookups = 1'000'000;
+  constexpr int threads = 4;
+
+  auto mail = std::make_shared<safe::mail_raw_t>();
+
+  // Held for the whole run, like the channels of a running session
+  auto named = mail->event<int>("test_event"sv);
+  auto declared = mail->event(test_event);
+
+  auto run = [&](const char *name, auto &&lookup) {
+    auto start = std::chrono::steady_clock::now();
+    {
+      std::vector<std::jthread> workers;
+      for (int x = 0; x < threads; ++x) {
+        workers.emplace_back([&]() {
+          for (int y = 0; y < lookups / threads; ++y) {
+            lookup();
+          }
+        });
+      }
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << name << ": " << elapsed.count() / lookups << " ns per lookup" << std::endl;
+  };
+
+  run("By name", [&]() {
+    return mail->event<int>("test_event"sv);
+  });
+  run("By declared id", [&]() {
+    return mail->event(test_event);
+  });
+}
@@ -5,6 +5,9 @@
 #pragma once
 #include "tests_common.h"
 
+// local includes
+#include <src/mail.h>
+
 struct SunshineEnvironment: testing::Environment {
   void SetUp() override {
     mail::man = std::make_shared<safe::mail_raw_t>();
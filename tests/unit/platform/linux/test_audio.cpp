@@ -0,0 +1,51 @@
+/**
+ * @file tests/unit/platform/linux/test_audio.cpp
+ * @brief Test src/platform/linux/audio.cpp.
+ */
+#ifdef __linux__
+  #include "../../../tests_common.h"
+
+  // standard includes
+  #include <vector>
+
+  #include <src/config.h>
+  #include <src/platform/common.h>
+
+using namespace std::literals;
+
+struct PulseAudioCaptureTest: PlatformTestSuite {};
+
+TEST_F(PulseAudioCaptureTest, NullSinkReportsCaptureLatency) {
+  auto control = platf::audio_control();
+  if (!control) {
+    GTEST_SKIP() << "No PulseAudio server is running";
+  }
+
+  auto sink = control->sink_info();
+  if (!sink || !sink->null) {
+    GTEST_SKIP() << "The Sunshine null sinks couldn't be created";
+  }
+
+  // Record the monitor of the stereo null sink, in fragments of a single 5 ms packet
+  auto previous_audio = config::audio;
+  auto fg = util::fail_guard([&]() {
+    config::audio = previous_audio;
+  });
+  config::audio.sink = sink->null->stereo;
+  config::audio.fragment = 5;
+  config::audio.max_buffer = 50;
+
+  constexpr std::uint32_t frame_size = 240;
+  auto mic = control->microphone(platf::speaker::map_stereo.data(), 2, 48000, frame_size, false, false);
+  ASSERT_TRUE(mic);
+
+  std::vector<float> frame(frame_size * 2);
+  for (int x = 0; x < 40; ++x) {
+    ASSERT_EQ(mic->sample(frame), platf::capture_e::ok);
+  }
+
+  auto latency = mic->capture_latency();
+  ASSERT_TRUE(latency);
+  EXPECT_LT(*latency, 100ms);
+}
+#endif
@@ -0,0 +1,166 @@
+/**
+ * @file tests/unit/platform/linux/test_misc.cpp
+ * @brief Test src/platform/linux/misc.cpp.
+ */
+#ifdef __linux__
+  #include "../../../tests_common.h"
+
+  // standard includes
+  #include <array>
+  #include <cstring>
+  #include <thread>
+  #include <vector>
+
+  // platform includes
+  #include <netinet/in.h>
+  #include <sys/socket.h>
+  #include <sys/time.h>
+  #include <unistd.h>
+
+  #include <src/platform/common.h>
+
+using namespace std::literals;
+
+namespace {
+  constexpr std::size_t header_size = sizeof(std::uint32_t);
+  constexpr std::size_t payload_size = 1000;
+
+  /**
+   * @brief UDP socket bound to an ephemeral loopback port.
+   */
+  struct loopback_socket_t {
+    loopback_socket_t() {
+      fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+
+      sockaddr_in addr = {};
+      addr.sin_family = AF_INET;
+      addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      bind(fd, (sockaddr *) &addr, sizeof(addr));
+
+      socklen_t len = sizeof(addr);
+      getsockname(fd, (sockaddr *) &addr, &len);
+      port = ntohs(addr.sin_port);
+    }
+
+    ~loopback_socket_t() {
+      close(fd);
+    }
+
+    int fd;
+    std::uint16_t port;
+  };
+
+  /**
+   * @brief Datagram read back from the loopback socket.
+   */
+  struct received_t {
+    std::uint32_t index;
+    std::chrono::nanoseconds timestamp;
+  };
+
+  std::vector<received_t> receive_all(int fd, std::size_t count) {
+    std::vector<received_t> received;
+
+    auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (received.size() < count && std::chrono::steady_clock::now() < deadline) {
+      std::array<char, header_size + payload_size> buf;
+      union {
+        char buf[CMSG_SPACE(sizeof(timespec))];
+        cmsghdr alignment;
+      } cmbuf;
+
+      iovec iov {buf.data(), buf.size()};
+      msghdr msg = {};
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      msg.msg_control = cmbuf.buf;
+      msg.msg_controllen = sizeof(cmbuf.buf);
+
+      auto bytes = recvmsg(fd, &msg, 0);
+      if (bytes < 0) {
+        std::this_thread::sleep_for(1ms);
+        continue;
+      }
+
+      EXPECT_EQ((std::size_t) bytes, buf.size());
+
+      received_t packet {};
+      std::memcpy(&packet.index, buf.data(), sizeof(packet.index));
+      for (auto cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+        if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_TIMESTAMPNS) {
+          timespec ts;
+          std::memcpy(&ts, CMSG_DATA(cm), sizeof(ts));
+          packet.timestamp = std::chrono::seconds {ts.tv_sec} + std::chrono::nanoseconds {ts.tv_nsec};
+        }
+      }
+      received.push_back(packet);
+    }
+
+    return received;
+  }
+}  // namespace
+
+TEST(SendBatchTxtimeTest, LoopbackDoesNotHonorLaunchTimes) {
+  // The loopback device has no queue, so launch times would be ignored
+  EXPECT_FALSE(platf::interface_honors_txtime("127.0.0.1"));
+}
+
+TEST(SendBatchTxtimeTest, UnknownAddressDoesNotHonorLaunchTimes) {
+  EXPECT_FALSE(platf::interface_honors_txtime("not an address"));
+}
+
+TEST(SendBatchTxtimeTest, LoopbackDeliversPacketsWithLaunchTimes) {
+  loopback_socket_t sender;
+  loopback_socket_t receiver;
+
+  if (!platf::enable_socket_txtime(sender.fd)) {
+    GTEST_SKIP() << "SO_TXTIME is not supported by this kernel";
+  }
+
+  int on = 1;
+  ASSERT_EQ(setsockopt(receiver.fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)), 0);
+
+  // 2 batches: a large one that is split across GSO messages and a single packet
+  constexpr std::size_t block_count = 50;
+  std::vector<std::uint32_t> headers(block_count);
+  std::vector<char> payload(block_count * payload_size, 'x');
+  for (std::uint32_t x = 0; x < block_count; ++x) {
+    headers[x] = x;
+  }
+
+  std::vector<platf::buffer_descriptor_t> buffers {{payload.data(), payload.size()}};
+  auto address = boost::asio::ip::make_address("127.0.0.1");
+
+  platf::batched_send_info_t send_info {
+    (const char *) headers.data(),
+    header_size,
+    buffers,
+    payload_size,
+    0,
+    block_count - 1,
+    (std::uintptr_t) sender.fd,
+    address,
+    receiver.port,
+    address,
+  };
+  send_info.launch_time = std::chrono::steady_clock::now() + 2ms;
+  send_info.block_interval = 100us;
+  ASSERT_TRUE(platf::send_batch(send_info));
+
+  send_info.block_offset = block_count - 1;
+  send_info.block_count = 1;
+  send_info.launch_time = send_info.launch_time_for_block(block_count);
+  ASSERT_TRUE(platf::send_batch(send_info));
+
+  auto received = receive_all(receiver.fd, block_count);
+  ASSERT_EQ(received.size(), block_count);
+
+  // Launch times never go backwards, so neither does the order or time of arrival
+  for (std::size_t x = 0; x < block_count; ++x) {
+    EXPECT_EQ(received[x].index, x);
+    if (x > 0) {
+      EXPECT_GE(received[x].timestamp, received[x - 1].timestamp);
+    }
+  }
+}
+#endif
@@ -18,6 +18,7 @@
 // local includes
 #include "src/config.h"
 #include "src/globals.h"
+#include "src/mail.h"
 #include "src/platform/virtualhid_input.h"
 
 using namespace std::chrono_literals;
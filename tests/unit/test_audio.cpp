@@ -4,7 +4,11 @@
  */
 #include "../tests_common.h"
 
+// standard includes
+#include <set>
+
 #include <src/audio.h>
+#include <src/mail.h>
 
 using namespace audio;
 
@@ -57,7 +61,7 @@ TEST_P(AudioTest, TestEncode) {
       if (shutdown_event->peek()) {
         break;
       }
-      if (auto packet_data = packet->second; packet_data.size() == 0) {
+      if (const auto &packet_data = std::get<1>(*packet); packet_data->size() == 0) {
         FAIL() << "Empty packet data";
       }
     }
@@ -67,3 +71,94 @@ TEST_P(AudioTest, TestEncode) {
   timer.join();
   capture.join();
 }
+
+TEST_P(AudioTest, TestSharedEncode) {
+  int first_session;
+  int second_session;
+  const auto second_mail = std::make_shared<safe::mail_raw_t>();
+  const auto packets = mail::man->queue<packet_t>(mail::audio_packets);
+
+  // Drop the packets earlier tests left in the queue
+  while (packets->pop(0ms)) {}
+
+  const auto start = std::chrono::steady_clock::now();
+
+  // Both sessions use the same settings, so they share a single capture and encoder
+  std::jthread first([&] {
+    audio::capture(m_mail, m_config, &first_session);
+  });
+  std::jthread second([&] {
+    audio::capture(second_mail, m_config, &second_session);
+  });
+
+  std::set<void *> sessions;
+  const auto deadline = std::chrono::steady_clock::now() + 1s;
+  while (sessions.size() < 2 && std::chrono::steady_clock::now() < deadline) {
+    const auto packet = packets->pop(100ms);
+
+    // Packets left over from other sessions are skipped
+    if (packet && (std::get<0>(*packet) == &first_session || std::get<0>(*packet) == &second_session)) {
+      EXPECT_NE(std::get<1>(*packet)->size(), 0);
+      sessions.emplace(std::get<0>(*packet));
+
+      // Samples are stamped when they are captured, and the stamp travels through the encoder
+      const auto capture_timestamp = std::get<2>(*packet);
+      EXPECT_GE(capture_timestamp, start);
+      EXPECT_LE(capture_timestamp, std::chrono::steady_clock::now());
+    }
+  }
+
+  m_mail->event<bool>(mail::shutdown)->raise(true);
+  second_mail->event<bool>(mail::shutdown)->raise(true);
+  first.join();
+  second.join();
+
+  if (sessions.empty()) {
+    GTEST_SKIP() << "Audio capture is not available";
+  }
+  EXPECT_TRUE(sessions.contains(&first_session));
+  EXPECT_TRUE(sessions.contains(&second_session));
+}
+
+TEST_P(AudioTest, PacketBuffersAreReused) {
+  constexpr std::size_t warm_up_packets = 50;
+  constexpr std::size_t packets_to_send = 200;
+
+  int session;
+  const auto packets = mail::man->queue<packet_t>(mail::audio_packets);
+  std::jthread capture([&] {
+    audio::capture(m_mail, m_config, &session);
+  });
+
+  // Packets are dropped as soon as they arrive, so only a few are ever in flight
+  std::shared_ptr<safe::pool_t<buffer_t>> pool;
+  std::uint64_t warm_allocations = 0;
+  std::size_t received = 0;
+  const auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (received < packets_to_send && std::chrono::steady_clock::now() < deadline) {
+    const auto packet = packets->pop(100ms);
+
+    // Packets left over from other sessions are skipped
+    if (!packet || std::get<0>(*packet) != &session) {
+      continue;
+    }
+
+    pool = std::get<1>(*packet).pool();
+    if (++received == warm_up_packets) {
+      warm_allocations = pool->allocations();
+    }
+  }
+
+  m_mail->event<bool>(mail::shutdown)->raise(true);
+  capture.join();
+
+  if (!received) {
+    GTEST_SKIP() << "Audio capture is not available";
+  }
+  ASSERT_TRUE(pool);
+  ASSERT_EQ(received, packets_to_send);
+
+  // Once warmed up, every packet is encoded into a buffer that was given back to the pool
+  EXPECT_GT(warm_allocations, 0U);
+  EXPECT_EQ(pool->allocations(), warm_allocations);
+}
@@ -48,3 +48,29 @@ TEST(CryptoTest, GeneratedCredentialsExposeSubjectAndVerifySignatures) {
   ASSERT_FALSE(signature.empty());
   ASSERT_TRUE(crypto::verify256(cert, payload, {reinterpret_cast<const char *>(signature.data()), signature.size()}));
 }
+
+TEST(CryptoTest, GcmScatterGatherEncryptMatchesContiguous) {
+  crypto::aes_t key(16, 0x42);
+  crypto::aes_t iv(12, 0x24);
+
+  std::string message(1432, '\0');
+  for (std::size_t x = 0; x < message.size(); ++x) {
+    message[x] = (char) (x * 7);
+  }
+
+  crypto::cipher::gcm_t cipher {key, false};
+
+  std::vector<std::uint8_t> expected(message.size());
+  std::array<std::uint8_t, crypto::cipher::tag_size> expected_tag;
+  ASSERT_EQ(cipher.encrypt(message, expected_tag.data(), expected.data(), &iv), (int) message.size());
+
+  // Split at an offset that is not a multiple of the AES block size
+  std::array<std::string_view, 2> parts {std::string_view {message}.substr(0, 31), std::string_view {message}.substr(31)};
+
+  std::vector<std::uint8_t> actual(message.size());
+  std::array<std::uint8_t, crypto::cipher::tag_size> actual_tag;
+  ASSERT_EQ(cipher.encrypt(parts, actual_tag.data(), actual.data(), &iv), (int) message.size());
+
+  EXPECT_EQ(actual, expected);
+  EXPECT_EQ(actual_tag, expected_tag);
+}
@@ -0,0 +1,131 @@
+/**
+ * @file tests/unit/test_gf256.cpp
+ * @brief Test src/gf256.*.
+ */
+#include "../tests_common.h"
+
+// standard includes
+#include <random>
+#include <tuple>
+#include <vector>
+
+// lib includes
+#include <rs.h>
+
+// local includes
+#include <src/gf256.h>
+
+using gf256::kernel_e;
+
+namespace {
+  /**
+   * @brief Randomly filled FEC block with a nanors parity matrix.
+   */
+  struct fec_block_t {
+    fec_block_t(int data_shards, int parity_shards, std::size_t blocksize):
+        data_shards {data_shards},
+        parity_shards {parity_shards},
+        blocksize {blocksize},
+        buffer((data_shards + parity_shards) * blocksize) {
+      std::mt19937 rng {(unsigned) (data_shards * 1000 + parity_shards)};
+      for (auto &b : buffer) {
+        b = (std::uint8_t) rng();
+      }
+
+      reed_solomon_init();
+      rs = reed_solomon_new(data_shards, parity_shards);
+    }
+
+    fec_block_t(const fec_block_t &) = delete;
+
+    ~fec_block_t() {
+      reed_solomon_release(rs);
+    }
+
+    std::vector<std::uint8_t *> shards() {
+      std::vector<std::uint8_t *> shards_p;
+      for (int x = 0; x < data_shards + parity_shards; ++x) {
+        shards_p.push_back(&buffer[x * blocksize]);
+      }
+      return shards_p;
+    }
+
+    std::vector<std::uint8_t> encode(kernel_e kernel) {
+      auto shards_p = shards();
+      gf256::encode(kernel, rs->p, data_shards, parity_shards, shards_p.data(), blocksize);
+      return buffer;
+    }
+
+    int data_shards;
+    int parity_shards;
+    std::size_t blocksize;
+    std::vector<std::uint8_t> buffer;
+    reed_solomon *rs;
+  };
+}  // namespace
+
+class GF256KernelTest: public testing::TestWithParam<kernel_e> {
+protected:
+  void SetUp() override {
+    if (!gf256::supported(GetParam())) {
+      GTEST_SKIP() << gf256::to_string(GetParam()) << " is not supported on this CPU";
+    }
+  }
+};
+
+INSTANTIATE_TEST_SUITE_P(
+  Kernels,
+  GF256KernelTest,
+  testing::Values(kernel_e::scalar, kernel_e::ssse3, kernel_e::avx2, kernel_e::avx512, kernel_e::neon),
+  [](const auto &info) {
+    std::string name {gf256::to_string(info.param)};
+    std::erase(name, '-');
+    return name;
+  }
+);
+
+TEST(GF256Tests, MultiplyMatchesFieldDefinition) {
+  // Shift-and-add multiplication modulo x^8 + x^4 + x^3 + x^2 + 1
+  auto slow_mul = [](std::uint8_t a, std::uint8_t b) {
+    std::uint8_t p = 0;
+    while (b) {
+      if (b & 1) {
+        p ^= a;
+      }
+      a = (a & 0x80) ? (std::uint8_t) ((a << 1) ^ 0x1D) : (std::uint8_t) (a << 1);
+      b >>= 1;
+    }
+    return p;
+  };
+
+  for (int a = 0; a < 256; ++a) {
+    for (int b = 0; b < 256; ++b) {
+      ASSERT_EQ(gf256::mul(a, b), slow_mul(a, b)) << a << " * " << b;
+    }
+  }
+}
+
+TEST(GF256Tests, ScalarMatchesNanors) {
+  for (auto [data_shards, parity_shards, blocksize] : {std::tuple {4, 2, 1400}, std::tuple {200, 40, 1416}, std::tuple {17, 3, 33}}) {
+    fec_block_t block {data_shards, parity_shards, (std::size_t) blocksize};
+
+    auto original = block.buffer;
+    auto shards_p = block.shards();
+    reed_solomon_encode(block.rs, shards_p.data(), data_shards + parity_shards, blocksize);
+
+    auto expected = block.buffer;
+    block.buffer = original;
+
+    EXPECT_EQ(block.encode(kernel_e::scalar), expected) << data_shards << '+' << parity_shards << " @ " << blocksize;
+  }
+}
+
+TEST_P(GF256KernelTest, MatchesScalar) {
+  // Odd block sizes exercise the scalar tail of each vector kernel
+  for (auto [data_shards, parity_shards, blocksize] : {std::tuple {4, 2, 1400}, std::tuple {200, 40, 1416}, std::tuple {1, 1, 1}, std::tuple {31, 7, 127}}) {
+    fec_block_t block {data_shards, parity_shards, (std::size_t) blocksize};
+
+    auto expected = fec_block_t {data_shards, parity_shards, (std::size_t) blocksize}.encode(kernel_e::scalar);
+    EXPECT_EQ(block.encode(GetParam()), expected) << data_shards << '+' << parity_shards << " @ " << blocksize;
+  }
+}
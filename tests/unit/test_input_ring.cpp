@@ -0,0 +1,133 @@
+/**
+ * @file tests/unit/test_input_ring.cpp
+ * @brief Test src/input_ring.*.
+ */
+#include "../tests_common.h"
+
+// standard includes
+#include <set>
+#include <vector>
+
+// local includes
+#include <src/input_ring.h>
+
+using namespace std::literals;
+using input_ring::latency_histogram_t;
+using input_ring::packet_t;
+using input_ring::ring_t;
+
+namespace {
+  std::vector<std::uint8_t> make_packet(std::uint8_t value, std::size_t size = 16) {
+    return std::vector<std::uint8_t>(size, value);
+  }
+}  // namespace
+
+TEST(InputRingTest, PacketsAreTakenInOrder) {
+  ring_t ring {8};
+
+  for (std::uint8_t x = 0; x < 5; ++x) {
+    ring.push(make_packet(x), input_ring::clock::time_point {x * 1ms});
+  }
+
+  std::vector<packet_t> batch;
+  ASSERT_EQ(ring.take(batch), 5U);
+  for (std::uint8_t x = 0; x < 5; ++x) {
+    EXPECT_EQ(batch[x].data, make_packet(x));
+    EXPECT_EQ(batch[x].received, input_ring::clock::time_point {x * 1ms});
+  }
+
+  EXPECT_EQ(ring.take(batch), 0U);
+}
+
+TEST(InputRingTest, FullRingGrowsWithoutDroppingPackets) {
+  ring_t ring {4};
+
+  std::vector<packet_t> batch;
+  for (std::uint8_t x = 0; x < 3; ++x) {
+    ring.push(make_packet(x), {});
+  }
+  ASSERT_EQ(ring.take(batch), 3U);
+
+  // Wraps around the end of the ring before it grows
+  for (std::uint8_t x = 0; x < 10; ++x) {
+    ring.push(make_packet(x, x + 1), {});
+  }
+  ASSERT_EQ(ring.take(batch), 10U);
+  for (std::uint8_t x = 0; x < 10; ++x) {
+    EXPECT_EQ(batch[x].data, make_packet(x, x + 1));
+  }
+
+  auto stats = ring.stats();
+  EXPECT_EQ(stats.pushed, 13U);
+  EXPECT_EQ(stats.high_water, 10U);
+  EXPECT_EQ(stats.grown, 2U);
+}
+
+TEST(InputRingTest, OnlyPushToIdleRingSchedulesDrain) {
+  ring_t ring;
+
+  EXPECT_TRUE(ring.push(make_packet(1), {}));
+  EXPECT_FALSE(ring.push(make_packet(2), {}));
+
+  // Still draining until the consumer finds the ring empty
+  std::vector<packet_t> batch;
+  ASSERT_EQ(ring.take(batch), 2U);
+  EXPECT_FALSE(ring.push(make_packet(3), {}));
+  ASSERT_EQ(ring.take(batch), 1U);
+  ASSERT_EQ(ring.take(batch), 0U);
+
+  EXPECT_TRUE(ring.push(make_packet(4), {}));
+}
+
+TEST(InputRingTest, BuffersAreReused) {
+  ring_t ring {4};
+
+  std::vector<packet_t> batch;
+  auto push_and_take = [&]() {
+    for (std::uint8_t x = 0; x < 4; ++x) {
+      ring.push(make_packet(x), {});
+    }
+    EXPECT_EQ(ring.take(batch), 4U);
+  };
+
+  // Once every slot of the ring and the batch has held a packet, no buffer is allocated anymore
+  push_and_take();
+  push_and_take();
+
+  std::set<const std::uint8_t *> buffers;
+  for (auto &packet : batch) {
+    buffers.emplace(packet.data.data());
+  }
+
+  for (int x = 0; x < 10; ++x) {
+    push_and_take();
+
+    for (auto &packet : batch) {
+      buffers.emplace(packet.data.data());
+    }
+  }
+
+  EXPECT_EQ(buffers.size(), 8U);
+}
+
+TEST(LatencyHistogramTest, SamplesLandInPowerOfTwoBuckets) {
+  latency_histogram_t histogram;
+
+  EXPECT_EQ(histogram.percentile(50), 0us);
+
+  histogram.record(0us);
+  histogram.record(3us);
+  histogram.record(100us);
+  histogram.record(1s);
+
+  auto counts = histogram.counts();
+  EXPECT_EQ(counts[0], 1U);
+  EXPECT_EQ(counts[2], 1U);
+  EXPECT_EQ(counts[7], 1U);
+  EXPECT_EQ(counts[latency_histogram_t::BUCKETS - 1], 1U);
+
+  EXPECT_EQ(histogram.percentile(25), 1us);
+  EXPECT_EQ(histogram.percentile(50), 4us);
+  EXPECT_EQ(histogram.percentile(75), 128us);
+  EXPECT_EQ(histogram.percentile(100), std::chrono::microseconds::max());
+}
@@ -0,0 +1,118 @@
+/**
+ * @file tests/unit/test_pacer.cpp
+ * @brief Test src/pacer.*.
+ */
+#include "../tests_common.h"
+
+// local includes
+#include <src/pacer.h>
+
+using namespace std::literals;
+using pacer::token_bucket_t;
+
+namespace {
+  // 8 Mbps at 100% headroom is 1 MB/s, or 1 byte per microsecond
+  constexpr pacer::params_t one_byte_per_us {
+    8'000,
+    100,
+    10'000,
+    10ms,
+    0,
+  };
+}  // namespace
+
+TEST(PacerTest, FullBucketSendsBurstWithoutWaiting) {
+  token_bucket_t pacer {one_byte_per_us};
+  auto now = token_bucket_t::clock::now();
+
+  pacer.begin_frame(100'000, now);
+  EXPECT_EQ(pacer.reserve(10'000, now), now);
+}
+
+TEST(PacerTest, DebtIsPaidBackAtRate) {
+  token_bucket_t pacer {one_byte_per_us};
+  auto now = token_bucket_t::clock::now();
+
+  pacer.begin_frame(100'000, now);
+  ASSERT_EQ(pacer.reserve(10'000, now), now);
+
+  // The bucket is empty, so the next 5000 bytes must wait 5ms
+  auto due = pacer.reserve(5'000, now);
+  EXPECT_EQ(due - now, 5ms);
+  EXPECT_EQ(pacer.ready_at(), due);
+
+  // Sending at the due time leaves no debt behind
+  due = pacer.reserve(1'000, due);
+  EXPECT_EQ(due - now, 6ms);
+}
+
+TEST(PacerTest, IdleTimeRefillsUpToBurst) {
+  token_bucket_t pacer {one_byte_per_us};
+  auto now = token_bucket_t::clock::now();
+
+  pacer.begin_frame(0, now);
+  pacer.reserve(10'000, now);
+
+  // A long idle period can't accumulate more than the burst size
+  now += 1s;
+  EXPECT_EQ(pacer.reserve(10'000, now), now);
+  EXPECT_EQ(pacer.reserve(1'000, now) - now, 1ms);
+}
+
+TEST(PacerTest, HeadroomScalesRate) {
+  auto params = one_byte_per_us;
+  params.headroom_percent = 250;
+
+  token_bucket_t pacer {params};
+  pacer.begin_frame(0, token_bucket_t::clock::now());
+  EXPECT_DOUBLE_EQ(pacer.rate(), 2'500'000);
+
+  pacer.set_bitrate(16'000);
+  EXPECT_DOUBLE_EQ(pacer.rate(), 5'000'000);
+}
+
+TEST(PacerTest, LargeFramesAreSpreadOverFrameInterval) {
+  auto params = one_byte_per_us;
+  params.spread_percent = 50;
+
+  token_bucket_t pacer {params};
+  auto now = token_bucket_t::clock::now();
+
+  // Small frames go at the headroom rate
+  pacer.begin_frame(1'000, now);
+  EXPECT_DOUBLE_EQ(pacer.rate(), 1'000'000);
+
+  // 100KB must be sent within half of the 10ms frame interval
+  pacer.begin_frame(100'000, now);
+  EXPECT_DOUBLE_EQ(pacer.rate(), 20'000'000);
+
+  auto due = now;
+  for (int x = 0; x < 10; ++x) {
+    due = pacer.reserve(10'000, due);
+  }
+  EXPECT_LE(due - now, 5ms);
+}
+
+TEST(PacerTest, ZeroRateNeverWaits) {
+  auto params = one_byte_per_us;
+  params.bitrate_kbps = 0;
+
+  token_bucket_t pacer {params};
+  auto now = token_bucket_t::clock::now();
+
+  pacer.begin_frame(1'000'000, now);
+  EXPECT_EQ(pacer.reserve(1'000'000, now), now);
+}
+
+TEST(PacerTest, StatsCountDelayedBatches) {
+  pacer::stats_t stats {};
+
+  stats.record(0ns);
+  stats.record(5ms);
+  stats.record(1ms);
+
+  EXPECT_EQ(stats.batches, 3U);
+  EXPECT_EQ(stats.delayed_batches, 2U);
+  EXPECT_EQ(stats.total_delay, 6ms);
+  EXPECT_EQ(stats.max_delay, 5ms);
+}
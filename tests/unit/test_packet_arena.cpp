@@ -0,0 +1,68 @@
+/**
+ * @file tests/unit/test_packet_arena.cpp
+ * @brief Test src/packet_arena.*.
+ */
+#include "../tests_common.h"
+
+// local includes
+#include <src/packet_arena.h>
+
+using packet_arena::arena_t;
+using packet_arena::buffer_t;
+
+TEST(PacketArenaTest, ReleasedBuffersAreReused) {
+  arena_t arena;
+
+  const char *first;
+  {
+    buffer_t<char> buffer {arena, 1000};
+    first = std::begin(buffer);
+    EXPECT_EQ(buffer.size(), 1000U);
+  }
+  EXPECT_EQ(arena.stats().pooled_bytes, 1024U);
+
+  // Any size of the same class gets the same memory back
+  buffer_t<char> buffer {arena, 600};
+  EXPECT_EQ(std::begin(buffer), first);
+  EXPECT_EQ(arena.stats().acquired, 2U);
+  EXPECT_EQ(arena.stats().allocations, 1U);
+  EXPECT_EQ(arena.stats().pooled_bytes, 0U);
+}
+
+TEST(PacketArenaTest, SizeClassesDontMix) {
+  arena_t arena;
+
+  { buffer_t<char> buffer {arena, 100}; }
+  { buffer_t<char> buffer {arena, 300}; }
+  EXPECT_EQ(arena.stats().allocations, 2U);
+
+  { buffer_t<uint8_t *> buffer {arena, 32}; }
+  EXPECT_EQ(arena.stats().allocations, 2U);
+}
+
+TEST(PacketArenaTest, OversizedBuffersAreNotPooled) {
+  arena_t arena;
+  auto oversized = arena_t::MIN_CLASS_SIZE << arena_t::SIZE_CLASSES;
+
+  { buffer_t<char> buffer {arena, oversized}; }
+  { buffer_t<char> buffer {arena, oversized}; }
+  EXPECT_EQ(arena.stats().allocations, 2U);
+  EXPECT_EQ(arena.stats().pooled_bytes, 0U);
+}
+
+TEST(PacketArenaTest, MovedBuffersAreReleasedOnce) {
+  arena_t arena;
+
+  buffer_t<char> target;
+  {
+    buffer_t<char> buffer {arena, 100};
+    buffer[0] = 'x';
+    target = std::move(buffer);
+  }
+  EXPECT_EQ(target[0], 'x');
+  EXPECT_EQ(arena.stats().pooled_bytes, 0U);
+
+  target = {};
+  EXPECT_EQ(target.size(), 0U);
+  EXPECT_EQ(arena.stats().pooled_bytes, arena_t::MIN_CLASS_SIZE);
+}
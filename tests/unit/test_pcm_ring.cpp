@@ -0,0 +1,142 @@
+/**
+ * @file tests/unit/test_pcm_ring.cpp
+ * @brief Test src/pcm_ring.*.
+ */
+#include "../tests_common.h"
+
+// standard includes
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// local includes
+#include <src/pcm_ring.h>
+
+using namespace std::literals;
+using pcm_ring::ring_t;
+
+namespace {
+  std::vector<float> make_frame(std::size_t samples, float value) {
+    return std::vector<float>(samples, value);
+  }
+}  // namespace
+
+TEST(PcmRingTest, FramesArePoppedInOrder) {
+  ring_t ring {4, 8, 5ms};
+
+  for (int x = 0; x < 3; ++x) {
+    ring.push(make_frame(8, (float) x).data(), ring_t::clock::time_point {x * 5ms});
+  }
+
+  std::vector<float> frame;
+  ring_t::clock::time_point timestamp;
+  for (int x = 0; x < 3; ++x) {
+    ASSERT_TRUE(ring.pop(frame, timestamp));
+    EXPECT_EQ(frame, make_frame(8, (float) x));
+    EXPECT_EQ(timestamp, ring_t::clock::time_point {x * 5ms});
+  }
+
+  EXPECT_EQ(ring.stats().pushed, 3U);
+  EXPECT_EQ(ring.stats().overruns, 0U);
+}
+
+TEST(PcmRingTest, FullRingDropsOnlyTheOldestFrame) {
+  ring_t ring {4, 8, 5ms};
+
+  for (int x = 0; x < 6; ++x) {
+    ring.push(make_frame(8, (float) x).data(), {});
+  }
+  EXPECT_EQ(ring.stats().overruns, 2U);
+
+  // The newest frames all survived
+  ring.stop();
+  std::vector<float> frame;
+  ring_t::clock::time_point timestamp;
+  for (int x = 2; x < 6; ++x) {
+    ASSERT_TRUE(ring.pop(frame, timestamp));
+    EXPECT_EQ(frame, make_frame(8, (float) x));
+  }
+  EXPECT_FALSE(ring.pop(frame, timestamp));
+}
+
+TEST(PcmRingTest, StopWakesWaitingConsumer) {
+  ring_t ring {4, 8, 5ms};
+
+  std::jthread consumer([&]() {
+    std::vector<float> frame;
+    ring_t::clock::time_point timestamp;
+    EXPECT_TRUE(ring.pop(frame, timestamp));
+    EXPECT_FALSE(ring.pop(frame, timestamp));
+  });
+
+  std::this_thread::sleep_for(10ms);
+  ring.push(make_frame(8, 1).data(), {});
+  std::this_thread::sleep_for(10ms);
+  ring.stop();
+  consumer.join();
+
+  // Neither the first frame nor the stop was due
+  EXPECT_EQ(ring.stats().underruns, 0U);
+}
+
+TEST(PcmRingTest, OnlyLateFramesAreUnderruns) {
+  ring_t ring {4, 8, 50ms};
+
+  std::jthread consumer([&]() {
+    std::vector<float> frame;
+    ring_t::clock::time_point timestamp;
+    while (ring.pop(frame, timestamp)) {
+    }
+  });
+
+  // Waiting for a frame that isn't due yet is normal
+  ring.push(make_frame(8, 0).data(), ring_t::clock::now());
+  std::this_thread::sleep_for(5ms);
+  ring.push(make_frame(8, 1).data(), ring_t::clock::now());
+
+  // This one arrives long after it was due
+  std::this_thread::sleep_for(200ms);
+  ring.push(make_frame(8, 2).data(), ring_t::clock::now());
+
+  std::this_thread::sleep_for(10ms);
+  ring.stop();
+  consumer.join();
+
+  EXPECT_EQ(ring.stats().underruns, 1U);
+}
+
+TEST(PcmRingTest, ConcurrentFramesAreNeverTorn) {
+  constexpr std::size_t frames = 20000;
+  constexpr std::size_t frame_samples = 480;
+  ring_t ring {4, frame_samples, 5ms};
+
+  std::jthread producer([&]() {
+    auto frame = make_frame(frame_samples, 0);
+    for (std::size_t x = 0; x < frames; ++x) {
+      std::fill(std::begin(frame), std::end(frame), (float) x);
+      ring.push(frame.data(), {});
+    }
+    ring.stop();
+  });
+
+  // Frames may be dropped when the consumer falls behind, but never mixed or reordered
+  std::size_t popped = 0;
+  float last = -1;
+  std::vector<float> frame;
+  ring_t::clock::time_point timestamp;
+  while (ring.pop(frame, timestamp)) {
+    ASSERT_GT(frame.front(), last);
+    ASSERT_TRUE(std::all_of(std::begin(frame), std::end(frame), [&](float sample) {
+      return sample == frame.front();
+    }));
+
+    last = frame.front();
+    ++popped;
+  }
+  producer.join();
+
+  auto stats = ring.stats();
+  EXPECT_EQ(stats.pushed, frames);
+  EXPECT_EQ(popped + stats.overruns, frames);
+  EXPECT_EQ(last, (float) (frames - 1));
+}
@@ -0,0 +1,226 @@
+/**
+ * @file tests/unit/test_rate_control.cpp
+ * @brief Test src/rate_control.*.
+ */
+#include "../tests_common.h"
+
+// local includes
+#include <src/rate_control.h>
+
+using namespace std::literals;
+using rate_control::audio_controller_t;
+using rate_control::bitrate_controller_t;
+using rate_control::fec_controller_t;
+
+namespace {
+  constexpr rate_control::fec_params_t fec_params {
+    5,
+    50,
+  };
+
+  constexpr rate_control::bitrate_params_t bitrate_params {
+    5'000,
+    20'000,
+    8ms,
+  };
+
+  constexpr rate_control::bitrate_feedback_t quiet {
+    0,
+    1000,
+    1ms,
+    0,
+  };
+
+  constexpr rate_control::audio_params_t audio_params {};
+}  // namespace
+
+TEST(FecControllerTest, InitialPercentageIsClamped) {
+  auto now = fec_controller_t::clock::now();
+
+  EXPECT_EQ(fec_controller_t(fec_params, 20, now).percentage(), 20);
+  EXPECT_EQ(fec_controller_t(fec_params, 1, now).percentage(), 5);
+  EXPECT_EQ(fec_controller_t(fec_params, 255, now).percentage(), 50);
+}
+
+TEST(FecControllerTest, LossRaisesPercentage) {
+  auto now = fec_controller_t::clock::now();
+  fec_controller_t controller {fec_params, 10, now};
+
+  // Light loss raises the percentage by one step
+  EXPECT_EQ(controller.on_loss_report(1, 1000, now), 20);
+
+  // Heavy loss raises it to twice the loss rate
+  EXPECT_EQ(controller.on_loss_report(150, 1000, now), 30);
+
+  // Without knowing how many packets were sent, only step up
+  EXPECT_EQ(controller.on_loss_report(5, 0, now), 40);
+
+  // Never beyond the maximum
+  EXPECT_EQ(controller.on_loss_report(900, 1000, now), 50);
+  EXPECT_EQ(controller.on_loss_report(900, 1000, now), 50);
+}
+
+TEST(FecControllerTest, QuietPeriodLowersPercentage) {
+  auto now = fec_controller_t::clock::now();
+  fec_controller_t controller {fec_params, 15, now};
+
+  // Reports without loss during the quiet period change nothing
+  EXPECT_EQ(controller.on_loss_report(0, 1000, now + 4s), 15);
+
+  EXPECT_EQ(controller.on_loss_report(0, 1000, now + 5s), 10);
+  EXPECT_EQ(controller.on_loss_report(0, 1000, now + 6s), 10);
+  EXPECT_EQ(controller.on_loss_report(0, 1000, now + 10s), 5);
+  EXPECT_EQ(controller.on_loss_report(0, 1000, now + 15s), 5);
+
+  // Loss restarts the quiet period
+  EXPECT_EQ(controller.on_loss_report(1, 1000, now + 16s), 15);
+  EXPECT_EQ(controller.on_loss_report(0, 1000, now + 20s), 15);
+  EXPECT_EQ(controller.on_loss_report(0, 1000, now + 21s), 10);
+}
+
+TEST(FecControllerTest, MaxPercentageFitsShardLimit) {
+  // 200 data shards in 4 blocks of 50: 50 * (100 + P) / 100 <= 255
+  EXPECT_EQ(rate_control::max_fec_percentage(200, 4, 255), 410);
+
+  // 1000 data shards in 4 blocks of 250 leave room for 2% parity
+  EXPECT_EQ(rate_control::max_fec_percentage(1000, 4, 255), 2);
+
+  // Too many data shards to fit any parity
+  EXPECT_EQ(rate_control::max_fec_percentage(1020, 4, 255), 0);
+  EXPECT_EQ(rate_control::max_fec_percentage(2000, 4, 255), 0);
+}
+
+TEST(BitrateControllerTest, CongestionSignals) {
+  bitrate_controller_t controller {bitrate_params, bitrate_controller_t::clock::now()};
+
+  EXPECT_FALSE(controller.congested(quiet));
+
+  // Loss within the threshold is left to FEC
+  EXPECT_FALSE(controller.congested({20, 1000, 1ms, 0}));
+  EXPECT_TRUE(controller.congested({21, 1000, 1ms, 0}));
+  EXPECT_TRUE(controller.congested({1, 0, 1ms, 0}));
+
+  EXPECT_TRUE(controller.congested({0, 1000, 9ms, 0}));
+  EXPECT_TRUE(controller.congested({0, 1000, 1ms, 3}));
+}
+
+TEST(BitrateControllerTest, CongestionLowersBitrateWithRateLimit) {
+  auto now = bitrate_controller_t::clock::now();
+  bitrate_controller_t controller {bitrate_params, now};
+  EXPECT_EQ(controller.target(), 20'000);
+
+  rate_control::bitrate_feedback_t lossy {100, 1000, 1ms, 0};
+
+  // Changes are at least a second apart
+  EXPECT_EQ(controller.on_feedback(lossy, now + 500ms), 20'000);
+  EXPECT_EQ(controller.on_feedback(lossy, now + 1s), 16'000);
+  EXPECT_EQ(controller.on_feedback(lossy, now + 1500ms), 16'000);
+  EXPECT_EQ(controller.on_feedback(lossy, now + 2s), 12'800);
+
+  // Never below the minimum
+  for (auto x = 3; x < 20; ++x) {
+    controller.on_feedback(lossy, now + std::chrono::seconds {x});
+  }
+  EXPECT_EQ(controller.target(), 5'000);
+}
+
+TEST(BitrateControllerTest, RecoversAfterQuietPeriod) {
+  auto now = bitrate_controller_t::clock::now();
+  bitrate_controller_t controller {bitrate_params, now};
+
+  ASSERT_EQ(controller.on_feedback({0, 1000, 1ms, 5}, now + 1s), 16'000);
+
+  // Quiet reports during the recovery delay change nothing
+  EXPECT_EQ(controller.on_feedback(quiet, now + 5s), 16'000);
+
+  EXPECT_EQ(controller.on_feedback(quiet, now + 6s), 16'800);
+  EXPECT_EQ(controller.on_feedback(quiet, now + 6500ms), 16'800);
+  EXPECT_EQ(controller.on_feedback(quiet, now + 7s), 17'640);
+
+  // Congestion while rate limited still restarts the recovery delay
+  EXPECT_EQ(controller.on_feedback({0, 1000, 20ms, 0}, now + 7500ms), 17'640);
+  EXPECT_EQ(controller.on_feedback(quiet, now + 12s), 17'640);
+  EXPECT_EQ(controller.on_feedback(quiet, now + 12500ms), 18'522);
+
+  // Never beyond the maximum
+  for (auto x = 13; x < 30; ++x) {
+    controller.on_feedback(quiet, now + std::chrono::seconds {x});
+  }
+  EXPECT_EQ(controller.target(), 20'000);
+}
+
+TEST(AudioControllerTest, LossEnablesInbandFec) {
+  auto now = audio_controller_t::clock::now();
+  audio_controller_t controller {audio_params, now};
+
+  ASSERT_EQ(controller.settings(), rate_control::audio_settings_t {});
+
+  auto settings = controller.on_loss_report(3, 100, now + 100ms);
+  EXPECT_TRUE(settings.inband_fec);
+  EXPECT_EQ(settings.loss_percentage, 3);
+  EXPECT_EQ(settings.bitrate_percentage, 100);
+
+  // The highest loss is held while the link keeps losing packets
+  EXPECT_EQ(controller.on_loss_report(1, 100, now + 200ms).loss_percentage, 3);
+  EXPECT_EQ(controller.on_loss_report(10, 100, now + 300ms).loss_percentage, 10);
+
+  // Without knowing how many packets were sent, and never beyond the maximum
+  EXPECT_EQ(controller.on_loss_report(1, 0, now + 400ms).loss_percentage, 25);
+  EXPECT_EQ(controller.on_loss_report(90, 100, now + 500ms).loss_percentage, 25);
+}
+
+TEST(AudioControllerTest, SustainedLossLowersBitrate) {
+  auto now = audio_controller_t::clock::now();
+  audio_controller_t controller {audio_params, now};
+
+  // A short burst of loss leaves the bitrate alone
+  for (auto t = 0ms; t < 2s; t += 500ms) {
+    EXPECT_EQ(controller.on_loss_report(1, 100, now + t).bitrate_percentage, 100);
+  }
+
+  EXPECT_EQ(controller.on_loss_report(1, 100, now + 2s).bitrate_percentage, 85);
+  EXPECT_EQ(controller.on_loss_report(1, 100, now + 2500ms).bitrate_percentage, 85);
+  EXPECT_EQ(controller.on_loss_report(1, 100, now + 3s).bitrate_percentage, 70);
+
+  // Never below the minimum
+  for (auto x = 4; x < 10; ++x) {
+    controller.on_loss_report(1, 100, now + std::chrono::seconds {x});
+  }
+  EXPECT_EQ(controller.settings().bitrate_percentage, 50);
+}
+
+TEST(AudioControllerTest, RecoversWithHysteresis) {
+  auto now = audio_controller_t::clock::now();
+  audio_controller_t controller {audio_params, now};
+
+  for (auto t = 0ms; t <= 3s; t += 500ms) {
+    controller.on_loss_report(1, 100, now + t);
+  }
+  ASSERT_EQ(controller.settings().bitrate_percentage, 70);
+
+  // Quiet reports during the quiet period change nothing
+  auto settings = controller.on_loss_report(0, 100, now + 7s);
+  EXPECT_TRUE(settings.inband_fec);
+  EXPECT_EQ(settings.bitrate_percentage, 70);
+
+  // In-band FEC goes away first, the bitrate comes back one step per quiet period
+  settings = controller.on_loss_report(0, 100, now + 8s);
+  EXPECT_FALSE(settings.inband_fec);
+  EXPECT_EQ(settings.loss_percentage, 0);
+  EXPECT_EQ(settings.bitrate_percentage, 80);
+
+  EXPECT_EQ(controller.on_loss_report(0, 100, now + 12s).bitrate_percentage, 80);
+  EXPECT_EQ(controller.on_loss_report(0, 100, now + 13s).bitrate_percentage, 90);
+
+  // New loss restarts the quiet period, and only counts as sustained after a while
+  settings = controller.on_loss_report(1, 100, now + 14s);
+  EXPECT_TRUE(settings.inband_fec);
+  EXPECT_EQ(settings.bitrate_percentage, 90);
+  EXPECT_EQ(controller.on_loss_report(0, 100, now + 18s).bitrate_percentage, 90);
+
+  // Never beyond the configured bitrate
+  for (auto x = 19; x < 40; ++x) {
+    controller.on_loss_report(0, 100, now + std::chrono::seconds {x});
+  }
+  EXPECT_EQ(controller.settings(), rate_control::audio_settings_t {});
+}
@@ -3,17 +3,37 @@
  * @brief Test src/stream.*
  */
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <numeric>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace stream {
   std::vector<uint8_t> concat_and_insert(uint64_t insert_size, uint64_t slice_size, const std::string_view &data1, const std::string_view &data2);
+  std::vector<uint8_t> replace(const std::string_view &original, const std::string_view &old, const std::string_view &_new);
+  void replace_head(std::vector<uint8_t> &head, std::string_view &tail, const std::string_view &old, const std::string_view &_new);
 }
 
 #include "../tests_common.h"
 
+// lib includes
+#include <boost/asio.hpp>
+#include <moonlight-common-c/src/Limelight-internal.h>
+
+// local includes
+#include <src/config.h>
+#include <src/crypto.h>
+#include <src/rtsp.h>
+#include <src/stream.h>
+#include <src/utility.h>
+
+using namespace std::literals;
+
 TEST(ConcatAndInsertTests, ConcatNoInsertionTest) {
   char b1[] = {'a', 'b'};
   char b2[] = {'c', 'd', 'e'};
@@ -37,3 +57,334 @@ TEST(ConcatAndInsertTests, ConcatSmallStrideTest) {
   auto expected = std::vector<uint8_t> {0, 'a', 0, 'b', 0, 'c', 0, 'd', 0, 'e'};
   ASSERT_EQ(res, expected);
 }
+
+namespace {
+  using bytes_t = std::vector<uint8_t>;
+
+  std::string_view view(const bytes_t &bytes) {
+    return {(const char *) bytes.data(), bytes.size()};
+  }
+
+  bytes_t join(std::initializer_list<bytes_t> parts) {
+    bytes_t joined;
+    for (auto &part : parts) {
+      joined.insert(std::end(joined), std::begin(part), std::end(part));
+    }
+    return joined;
+  }
+
+  // Deterministic stand-in for coded slice data
+  bytes_t slice(uint8_t nal_header, std::size_t size) {
+    bytes_t nal {0, 0, 1, nal_header};
+    uint32_t state = 0x12345678;
+    while (nal.size() < size) {
+      state = state * 1664525 + 1013904223;
+      nal.push_back((uint8_t) (state >> 24));
+    }
+    return nal;
+  }
+
+  // Parameter sets from an H.264 IDR frame, before and after VUI injection
+  const bytes_t h264_aud {0, 0, 0, 1, 0x09, 0xf0};
+  const bytes_t h264_sps {0, 0, 0, 1, 0x67, 0x64, 0x00, 0x2a, 0xac, 0xd9, 0x40, 0x78, 0x02, 0x27, 0xe5, 0x9a, 0x80, 0x80, 0x80, 0xa0};
+  const bytes_t h264_sps_vui {0, 0, 0, 1, 0x67, 0x64, 0x00, 0x2a, 0xac, 0xd9, 0x40, 0x78, 0x02, 0x27, 0xe5, 0x9a, 0x80, 0x80, 0x80, 0xa0, 0x00, 0x00, 0x03, 0x00, 0x20, 0x00, 0x00, 0x07, 0x81, 0xe3, 0x06, 0x54};
+  const bytes_t h264_pps {0, 0, 0, 1, 0x68, 0xeb, 0xe3, 0xcb, 0x22, 0xc0};
+
+  // Parameter sets from an HEVC IDR frame, before and after VUI injection
+  const bytes_t hevc_vps {0, 0, 0, 1, 0x40, 0x01, 0x0c, 0x01, 0xff, 0xff, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x7b, 0x95, 0x98, 0x09};
+  const bytes_t hevc_vps_new {0, 0, 0, 1, 0x40, 0x01, 0x0c, 0x01, 0xff, 0xff, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x7b, 0x95, 0x98, 0x0c, 0x00, 0x00, 0x0f, 0xa0, 0x00, 0x01, 0xd4, 0xc0, 0x40};
+  const bytes_t hevc_sps {0, 0, 0, 1, 0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x7b, 0xa0, 0x03, 0xc0, 0x80, 0x10, 0xe5, 0x96, 0x56, 0x69, 0x24, 0xca, 0xe0, 0x10};
+  const bytes_t hevc_sps_vui {0, 0, 0, 1, 0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x7b, 0xa0, 0x03, 0xc0, 0x80, 0x10, 0xe5, 0x96, 0x56, 0x69, 0x24, 0xca, 0xf0, 0x16, 0x9c, 0x20, 0x00, 0x00, 0x7d, 0x20, 0x00, 0x0e, 0xa6, 0x04};
+  const bytes_t hevc_pps {0, 0, 0, 1, 0x44, 0x01, 0xc1, 0x72, 0xb4, 0x62, 0x40};
+
+  /**
+   * @brief Apply replacements the way the video sender did before it rewrote only the head.
+   */
+  bytes_t replace_all(bytes_t frame, const std::vector<std::pair<bytes_t, bytes_t>> &replacements) {
+    for (auto &[old, _new] : replacements) {
+      frame = stream::replace(view(frame), view(old), view(_new));
+    }
+    return frame;
+  }
+
+  /**
+   * @brief Apply replacements with replace_head() and return the head followed by the tail.
+   */
+  bytes_t replace_heads(const bytes_t &frame, const std::vector<std::pair<bytes_t, bytes_t>> &replacements, std::size_t *tail_size = nullptr) {
+    bytes_t head;
+    auto tail = view(frame);
+    for (auto &[old, _new] : replacements) {
+      stream::replace_head(head, tail, view(old), view(_new));
+    }
+
+    if (tail_size) {
+      *tail_size = tail.size();
+    }
+
+    // The tail must still point into the original frame
+    EXPECT_EQ(tail.data() + tail.size(), (const char *) frame.data() + frame.size());
+    return join({head, bytes_t {std::begin(tail), std::end(tail)}});
+  }
+}  // namespace
+
+TEST(ReplaceHeadTests, H264IdrMatchesFullReplace) {
+  auto frame = join({h264_aud, h264_sps, h264_pps, slice(0x65, 64 * 1024)});
+  std::vector<std::pair<bytes_t, bytes_t>> replacements {{h264_sps, h264_sps_vui}};
+
+  std::size_t tail_size;
+  auto replaced = replace_heads(frame, replacements, &tail_size);
+
+  EXPECT_EQ(replaced, replace_all(frame, replacements));
+  EXPECT_EQ(replaced, join({h264_aud, h264_sps_vui, h264_pps, slice(0x65, 64 * 1024)}));
+
+  // Only the bytes up to the end of the SPS were copied
+  EXPECT_EQ(tail_size, frame.size() - h264_aud.size() - h264_sps.size());
+}
+
+TEST(ReplaceHeadTests, HevcIdrMatchesFullReplace) {
+  auto frame = join({hevc_vps, hevc_sps, hevc_pps, slice(0x26, 64 * 1024)});
+  std::vector<std::pair<bytes_t, bytes_t>> replacements {{hevc_vps, hevc_vps_new}, {hevc_sps, hevc_sps_vui}};
+
+  std::size_t tail_size;
+  auto replaced = replace_heads(frame, replacements, &tail_size);
+
+  EXPECT_EQ(replaced, replace_all(frame, replacements));
+  EXPECT_EQ(replaced, join({hevc_vps_new, hevc_sps_vui, hevc_pps, slice(0x26, 64 * 1024)}));
+  EXPECT_EQ(tail_size, frame.size() - hevc_vps.size() - hevc_sps.size());
+}
+
+TEST(ReplaceHeadTests, MissingSequenceLeavesFrameUntouched) {
+  auto frame = join({h264_aud, h264_pps, slice(0x65, 4096)});
+  std::vector<std::pair<bytes_t, bytes_t>> replacements {{h264_sps, h264_sps_vui}};
+
+  std::size_t tail_size;
+  EXPECT_EQ(replace_heads(frame, replacements, &tail_size), frame);
+  EXPECT_EQ(tail_size, frame.size());
+}
+
+TEST(ReplaceHeadTests, OnlyFirstMatchIsReplaced) {
+  auto frame = join({h264_sps, h264_sps, slice(0x65, 4096)});
+  std::vector<std::pair<bytes_t, bytes_t>> replacements {{h264_sps, h264_sps_vui}};
+
+  EXPECT_EQ(replace_heads(frame, replacements), replace_all(frame, replacements));
+}
+
+TEST(ReplaceHeadTests, MatchesInsideAndAcrossHead) {
+  auto frame = join({bytes_t {'a', 'b', 'c'}, slice(0x65, 256)});
+
+  // The second replacement matches inside the rewritten head, the third one straddles it
+  std::vector<std::pair<bytes_t, bytes_t>> replacements {
+    {{'b'}, {'x', 'y', 'z'}},
+    {{'y'}, {'w'}},
+    {{'z', 'c', 0, 0, 1}, {'q'}},
+  };
+
+  EXPECT_EQ(replace_heads(frame, replacements), replace_all(frame, replacements));
+  EXPECT_EQ(replace_heads(frame, replacements), join({bytes_t {'a', 'x', 'w', 'q'}, bytes_t {std::begin(frame) + 6, std::end(frame)}}));
+}
+
+namespace {
+  /**
+   * @brief RTP and video packet headers, as laid out by the video sender.
+   */
+  struct video_packet_header_t {
+    RTP_PACKET rtp;
+    char reserved[4];
+    NV_VIDEO_PACKET packet;
+  };
+
+  /**
+   * @brief Encryption prefix of a video packet, as laid out by the video sender.
+   */
+  struct video_packet_enc_prefix_t {
+    std::uint8_t iv[12];
+    std::uint32_t frameNumber;
+    std::uint8_t tag[16];
+  };
+}  // namespace
+
+class VideoEncryptionTest: public testing::TestWithParam<int> {
+protected:
+  void SetUp() override {
+    config::stream.fec_threads = GetParam();
+  }
+
+  void TearDown() override {
+    config::stream = original_stream;
+  }
+
+  config::stream_t original_stream {config::stream};
+};
+
+INSTANTIATE_TEST_SUITE_P(
+  FecThreads,
+  VideoEncryptionTest,
+  testing::Values(1, 4)
+);
+
+TEST_P(VideoEncryptionTest, PacketsDecryptWithConsecutiveIVs) {
+  // A frame split across several FEC blocks, a single-block frame split across the ciphers, and a tiny frame
+  std::vector<stream::testing::recorded_frame_t> frames {
+    {0ms, 400'000, true},
+    {16ms, 60'000, false},
+    {33ms, 500, false},
+  };
+
+  boost::asio::io_context io;
+  boost::asio::ip::udp::socket sink {io, boost::asio::ip::udp::endpoint {boost::asio::ip::address_v4::loopback(), 0}};
+  sink.set_option(boost::asio::socket_base::receive_buffer_size {8 * 1024 * 1024});
+
+  // Read the packets while they are sent, until the empty datagram sent after the last frame
+  std::vector<std::vector<char>> received;
+  std::thread receiver {[&]() {
+    std::array<char, 2048> buffer;
+    while (auto size = sink.receive(boost::asio::buffer(buffer))) {
+      received.emplace_back(std::begin(buffer), std::begin(buffer) + size);
+    }
+  }};
+
+  stream::config_t config {};
+  config.monitor.width = 1920;
+  config.monitor.height = 1080;
+  config.monitor.framerate = 60;
+  config.monitor.bitrate = 25'000;
+  config.packetsize = 1392;
+  config.minRequiredFecPackets = 2;
+  config.encryptionFlagsEnabled = SS_ENC_VIDEO;
+
+  rtsp_stream::launch_session_t launch_session {};
+  launch_session.gcm_key = crypto::aes_t(16, 0x42);
+  launch_session.iv = crypto::aes_t(16, 0x24);
+
+  auto session = stream::session::alloc(config, launch_session);
+  auto stats = stream::testing::replay_video(*session, frames, sink.local_endpoint().port());
+
+  sink.send_to(boost::asio::const_buffer {}, sink.local_endpoint());
+  receiver.join();
+
+  ASSERT_EQ(stats.frames, frames.size());
+  ASSERT_EQ(received.size(), stats.packets);
+
+  crypto::cipher::gcm_t cipher {launch_session.gcm_key, false};
+  std::vector<std::uint8_t> plaintext;
+  std::uint32_t last_frame = 0;
+  for (std::uint64_t iv_counter = 0; iv_counter < received.size(); ++iv_counter) {
+    auto &packet = received[iv_counter];
+    ASSERT_GT(packet.size(), sizeof(video_packet_enc_prefix_t) + sizeof(video_packet_header_t));
+    auto *prefix = (video_packet_enc_prefix_t *) packet.data();
+
+    // Every packet of the session takes the next IV, whichever thread encrypted it
+    crypto::aes_t iv(12);
+    std::copy_n((std::uint8_t *) &iv_counter, sizeof(iv_counter), std::begin(iv));
+    iv[11] = 'V';
+    ASSERT_TRUE(std::equal(std::begin(iv), std::end(iv), prefix->iv)) << "packet " << iv_counter;
+
+    // The tag directly precedes the ciphertext, as decrypt() expects
+    std::string_view tagged_cipher {(char *) prefix->tag, packet.size() - offsetof(video_packet_enc_prefix_t, tag)};
+    ASSERT_EQ(cipher.decrypt(tagged_cipher, plaintext, &iv), 0) << "packet " << iv_counter;
+
+    auto *header = (video_packet_header_t *) plaintext.data();
+    EXPECT_EQ(util::endian::big<std::uint16_t>(header->rtp.sequenceNumber), (std::uint16_t) iv_counter);
+    EXPECT_EQ(header->packet.frameIndex, prefix->frameNumber);
+
+    // Frames are sent whole and in order
+    EXPECT_TRUE(prefix->frameNumber == last_frame || prefix->frameNumber == last_frame + 1);
+    last_frame = prefix->frameNumber;
+  }
+  EXPECT_EQ(last_frame, frames.size());
+}
+
+TEST(VideoSendLoopTest, SteadyStateFramesDontAllocate) {
+  // The same frames twice, the second time the packet arena already holds every buffer they need
+  std::vector<stream::testing::recorded_frame_t> frames;
+  for (int pass = 0; pass < 2; ++pass) {
+    for (int x = 0; x < 30; ++x) {
+      auto timestamp = std::chrono::microseconds {(pass * 30 + x) * 16'667};
+      frames.push_back({timestamp, x % 10 == 0 ? 300'000 : 20'000 + (std::size_t) x * 1'000, x % 10 == 0});
+    }
+  }
+
+  boost::asio::io_context io;
+  boost::asio::ip::udp::socket sink {io, boost::asio::ip::udp::endpoint {boost::asio::ip::address_v4::loopback(), 0}};
+
+  for (auto encryption_flags : {0U, (std::uint32_t) SS_ENC_VIDEO}) {
+    stream::config_t config {};
+    config.monitor.width = 1920;
+    config.monitor.height = 1080;
+    config.monitor.framerate = 60;
+    config.monitor.bitrate = 25'000;
+    config.packetsize = 1392;
+    config.minRequiredFecPackets = 2;
+    config.encryptionFlagsEnabled = encryption_flags;
+
+    rtsp_stream::launch_session_t launch_session {};
+    launch_session.gcm_key = crypto::aes_t(16, 0x42);
+    launch_session.iv = crypto::aes_t(16, 0x24);
+
+    auto session = stream::session::alloc(config, launch_session);
+    auto stats = stream::testing::replay_video(*session, frames, sink.local_endpoint().port());
+    ASSERT_EQ(stats.frame_allocations.size(), frames.size());
+
+    auto warm = std::begin(stats.frame_allocations) + frames.size() / 2;
+    EXPECT_GT(std::accumulate(std::begin(stats.frame_allocations), warm, std::uint64_t {0}), 0U);
+    EXPECT_EQ(std::accumulate(warm, std::end(stats.frame_allocations), std::uint64_t {0}), 0U) << "encryption flags " << encryption_flags;
+  }
+}
+
+class AudioSendLoopTest: public testing::TestWithParam<bool> {};
+
+INSTANTIATE_TEST_SUITE_P(
+  Fec,
+  AudioSendLoopTest,
+  testing::Bool()
+);
+
+TEST_P(AudioSendLoopTest, PacketsAreSentWithOrWithoutEncoder) {
+  constexpr std::size_t packet_count = 40;
+  auto fec = GetParam();
+
+  boost::asio::io_context io;
+  boost::asio::ip::udp::socket sink {io, boost::asio::ip::udp::endpoint {boost::asio::ip::address_v4::loopback(), 0}};
+
+  // Read the packets while they are sent, until the empty datagram sent after the last one
+  std::vector<std::vector<char>> received;
+  std::thread receiver {[&]() {
+    std::array<char, 2048> buffer;
+    while (auto size = sink.receive(boost::asio::buffer(buffer))) {
+      received.emplace_back(std::begin(buffer), std::begin(buffer) + size);
+    }
+  }};
+
+  stream::config_t config {};
+  config.audio.packetDuration = 5;
+
+  rtsp_stream::launch_session_t launch_session {};
+  launch_session.gcm_key = crypto::aes_t(16, 0x42);
+  launch_session.iv = crypto::aes_t(16, 0x24);
+
+  auto session = stream::session::alloc(config, launch_session);
+  stream::testing::replay_audio(*session, packet_count, sink.local_endpoint().port(), fec);
+
+  sink.send_to(boost::asio::const_buffer {}, sink.local_endpoint());
+  receiver.join();
+
+  std::uint16_t data_packets = 0;
+  std::size_t parity_packets = 0;
+  for (auto &packet : received) {
+    ASSERT_GT(packet.size(), sizeof(RTP_PACKET));
+    auto *rtp = (RTP_PACKET *) packet.data();
+
+    if (rtp->packetType == 127) {
+      ++parity_packets;
+      continue;
+    }
+
+    ASSERT_EQ(rtp->packetType, 97);
+    EXPECT_EQ(util::endian::big(rtp->sequenceNumber), data_packets);
+    ++data_packets;
+  }
+
+  // Without an encoder, the audio still goes out, just without its parity shards
+  EXPECT_EQ(data_packets, packet_count);
+  EXPECT_EQ(parity_packets, fec ? packet_count / RTPA_DATA_SHARDS * RTPA_FEC_SHARDS : 0);
+}
@@ -0,0 +1,150 @@
+/**
+ * @file tests/unit/test_task_pool.cpp
+ * @brief Test src/task_pool.h.
+ */
+#include "../tests_common.h"
+
+// standard includes
+#include <random>
+#include <thread>
+#include <vector>
+
+// local includes
+#include <src/task_pool.h>
+
+using namespace std::literals;
+using task_pool_util::TaskPool;
+
+namespace {
+  /**
+   * @brief Task pool that exposes its timer heap, to check it stays bounded.
+   */
+  struct inspected_pool_t: TaskPool {
+    using TaskPool::_timer_heap;
+  };
+
+  /**
+   * @brief Run every task that is due now.
+   */
+  int run_ready(TaskPool &pool) {
+    int ran = 0;
+    while (auto task = pool.pop()) {
+      (*task)->run();
+      ++ran;
+    }
+
+    return ran;
+  }
+}  // namespace
+
+TEST(TaskPoolTest, DelayedTasksRunInDueOrder) {
+  TaskPool pool;
+
+  std::vector<int> order;
+  pool.pushDelayed([&]() {
+    order.push_back(3);
+  }, 3ms);
+  pool.pushDelayed([&]() {
+    order.push_back(1);
+  }, 1ms);
+  pool.pushDelayed([&]() {
+    order.push_back(2);
+  }, 2ms);
+
+  ASSERT_TRUE(pool.next());
+  std::this_thread::sleep_until(*pool.next() + 2ms);
+
+  EXPECT_EQ(run_ready(pool), 3);
+  EXPECT_EQ(order, (std::vector<int> {1, 2, 3}));
+  EXPECT_FALSE(pool.next());
+}
+
+TEST(TaskPoolTest, CancelledTasksNeverRun) {
+  TaskPool pool;
+
+  bool ran = false;
+  auto task_id = pool.pushDelayed([&]() {
+    ran = true;
+  }, 0ms).task_id;
+
+  EXPECT_TRUE(pool.cancel(task_id));
+  EXPECT_FALSE(pool.cancel(task_id));
+
+  EXPECT_EQ(run_ready(pool), 0);
+  EXPECT_FALSE(ran);
+  EXPECT_FALSE(pool.next());
+}
+
+TEST(TaskPoolTest, DelayReschedulesTask) {
+  TaskPool pool;
+
+  int ran = 0;
+  auto task_id = pool.pushDelayed([&]() {
+    ++ran;
+  }, 0ms).task_id;
+  pool.delay(task_id, 1h);
+
+  EXPECT_FALSE(pool.ready());
+  EXPECT_GT(*pool.next(), std::chrono::steady_clock::now() + 30min);
+
+  pool.delay(task_id, 0ms);
+  EXPECT_EQ(run_ready(pool), 1);
+  EXPECT_EQ(ran, 1);
+}
+
+TEST(TaskPoolTest, ChurnKeepsTimerHeapBounded) {
+  inspected_pool_t pool;
+
+  // Like key repeat, which cancels and reschedules a task for every key event
+  auto task_id = pool.pushDelayed([]() {}, 1h).task_id;
+  for (int x = 0; x < 10'000; ++x) {
+    ASSERT_TRUE(pool.cancel(task_id));
+    task_id = pool.pushDelayed([]() {}, 1h).task_id;
+  }
+
+  EXPECT_LE(pool._timer_heap.size(), 100U);
+  EXPECT_TRUE(pool.cancel(task_id));
+  EXPECT_FALSE(pool.next());
+}
+
+TEST(TaskPoolTest, ChurnedTasksAllRunInDueOrder) {
+  constexpr int tasks = 1'000;
+
+  TaskPool pool;
+  std::mt19937 rng {42};
+  std::uniform_int_distribution<int> delay_us {0, 20'000};
+
+  int ran = 0;
+  std::vector<TaskPool::task_id_t> task_ids;
+  for (int x = 0; x < tasks; ++x) {
+    task_ids.push_back(pool.pushDelayed([&]() {
+      ++ran;
+    }, std::chrono::microseconds {delay_us(rng)}).task_id);
+  }
+
+  // Cancel every other task, and push every cancelled one back as a new task
+  for (int x = 0; x < tasks; x += 2) {
+    ASSERT_TRUE(pool.cancel(task_ids[x]));
+    pool.pushDelayed([&]() {
+      ++ran;
+    }, std::chrono::microseconds {delay_us(rng)});
+  }
+
+  // Wait for each task to be due instead of a fixed time, a slow machine only takes longer
+  auto deadline = std::chrono::steady_clock::now() + 30s;
+  auto last_due = std::chrono::steady_clock::time_point::min();
+  while (auto next = pool.next()) {
+    ASSERT_TRUE(std::chrono::steady_clock::now() < deadline);
+    std::this_thread::sleep_until(*next);
+
+    while (pool.ready()) {
+      auto due = *pool.next();
+      ASSERT_GE(due, last_due);
+      last_due = due;
+
+      (*pool.pop())->run();
+    }
+  }
+
+  EXPECT_EQ(ran, tasks);
+}
@@ -0,0 +1,92 @@
+/**
+ * @file tests/unit/test_thread_pool.cpp
+ * @brief Test src/thread_pool.h.
+ */
+#include "../tests_common.h"
+
+// standard includes
+#include <atomic>
+#include <functional>
+#include <future>
+#include <thread>
+#include <vector>
+
+// local includes
+#include <src/thread_pool.h>
+
+using namespace std::literals;
+using thread_pool_util::ThreadPool;
+
+TEST(ThreadPoolTest, TasksFromOtherThreadsRun) {
+  ThreadPool pool {4};
+
+  std::vector<std::future<int>> futures;
+  for (int x = 0; x < 1000; ++x) {
+    futures.emplace_back(pool.push([x]() {
+      return x * 2;
+    }));
+  }
+
+  for (int x = 0; x < 1000; ++x) {
+    EXPECT_EQ(futures[x].get(), x * 2);
+  }
+}
+
+TEST(ThreadPoolTest, TasksFromWorkersRun) {
+  ThreadPool pool {2};
+
+  std::atomic_int ran {0};
+  pool.push([&]() {
+    // Queued while this worker is busy, the other one runs them
+    for (int x = 0; x < 1000; ++x) {
+      pool.push([&]() {
+        ran.fetch_add(1);
+      });
+    }
+  }).get();
+
+  while (ran.load() < 1000) {
+    std::this_thread::yield();
+  }
+}
+
+TEST(ThreadPoolTest, DelayedTasksRunWhileBusy) {
+  ThreadPool pool {1};
+
+  // Keep the only worker busy with a chain of tasks
+  std::atomic_bool busy {true};
+  std::function<void()> spin = [&]() {
+    if (busy) {
+      pool.push(spin);
+    }
+  };
+  pool.push(spin);
+
+  auto delayed = pool.pushDelayed([]() {
+    return 42;
+  }, 5ms);
+  auto cancelled = pool.pushDelayed([]() {}, 5ms);
+  EXPECT_TRUE(pool.cancel(cancelled.task_id));
+
+  ASSERT_EQ(delayed.future.wait_for(1s), std::future_status::ready);
+  EXPECT_EQ(delayed.future.get(), 42);
+  busy = false;
+}
+
+TEST(ThreadPoolTest, StopRunsRemainingTasks) {
+  std::atomic_int ran {0};
+  {
+    ThreadPool pool;
+    for (int x = 0; x < 100; ++x) {
+      pool.push([&]() {
+        ran.fetch_add(1);
+      });
+    }
+
+    pool.start(2);
+    pool.stop();
+    pool.join();
+  }
+
+  EXPECT_EQ(ran.load(), 100);
+}
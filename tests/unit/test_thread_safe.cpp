@@ -0,0 +1,206 @@
+/**
+ * @file tests/unit/test_thread_safe.cpp
+ * @brief Test src/thread_safe.h.
+ */
+#include "../tests_common.h"
+
+// standard includes
+#include <thread>
+#include <vector>
+
+// local includes
+#include <src/thread_safe.h>
+
+using namespace std::literals;
+
+TEST(PoolTest, ReleasedObjectsAreReused) {
+  auto pool = safe::pool_t<std::vector<float>>::make([]() {
+    return std::vector<float>(480);
+  }, 4);
+
+  const float *first;
+  {
+    auto samples = pool->acquire();
+    first = samples->data();
+  }
+
+  auto samples = pool->acquire();
+  EXPECT_EQ(samples->data(), first);
+  EXPECT_EQ(pool->allocations(), 1U);
+}
+
+TEST(PoolTest, ExtraObjectsAreDestroyed) {
+  auto pool = safe::pool_t<int>::make([]() {
+    return 0;
+  }, 1);
+
+  auto first = pool->acquire();
+  auto second = pool->acquire();
+  *first = 1;
+  *second = 2;
+
+  // Only the object given back first is kept
+  second = {};
+  first = {};
+
+  auto kept = pool->acquire();
+  auto created = pool->acquire();
+  EXPECT_EQ(*kept, 2);
+  EXPECT_EQ(*created, 0);
+  EXPECT_EQ(pool->allocations(), 3U);
+}
+
+TEST(PoolTest, ObjectsOutliveTheirPool) {
+  auto pool = safe::pool_t<std::vector<float>>::make([]() {
+    return std::vector<float>(480);
+  }, 4);
+
+  auto samples = pool->acquire();
+  pool.reset();
+
+  EXPECT_EQ(samples->size(), 480U);
+}
+
+TEST(QueueTest, ElementsArePoppedInOrderAcrossWraps) {
+  safe::queue_t<int> queue {4};
+
+  for (int x = 0; x < 10; ++x) {
+    queue.raise(x);
+    queue.raise(x + 100);
+
+    EXPECT_EQ(queue.pop(0ms), x);
+    EXPECT_EQ(queue.pop(0ms), x + 100);
+  }
+
+  EXPECT_FALSE(queue.pop(0ms));
+  EXPECT_EQ(queue.stats().high_water, 2U);
+}
+
+TEST(QueueTest, DropOldestKeepsNewestElements) {
+  safe::queue_t<int> queue {3};
+
+  for (int x = 0; x < 5; ++x) {
+    queue.raise(x);
+  }
+
+  std::vector<int> queued;
+  for (auto value : queue.unsafe()) {
+    queued.emplace_back(value);
+  }
+  EXPECT_EQ(queued, (std::vector<int> {2, 3, 4}));
+
+  auto stats = queue.stats();
+  EXPECT_EQ(stats.high_water, 3U);
+  EXPECT_EQ(stats.overflows, 2U);
+  EXPECT_EQ(stats.dropped, 2U);
+}
+
+TEST(QueueTest, DropNewestKeepsQueuedElements) {
+  safe::queue_t<int> queue {3, safe::overflow_e::drop_newest};
+
+  for (int x = 0; x < 5; ++x) {
+    queue.raise(x);
+  }
+
+  for (int x = 0; x < 3; ++x) {
+    EXPECT_EQ(queue.pop(0ms), x);
+  }
+  EXPECT_EQ(queue.stats().dropped, 2U);
+}
+
+TEST(QueueTest, CountIfOnlyCountsMatchingElements) {
+  safe::queue_t<int> queue {4};
+
+  // Wraps around the end of the ring
+  queue.raise(1);
+  queue.raise(2);
+  queue.pop(0ms);
+  queue.pop(0ms);
+  for (int x = 0; x < 4; ++x) {
+    queue.raise(x);
+  }
+
+  auto odd = [](int value) {
+    return value % 2 == 1;
+  };
+  EXPECT_EQ(queue.count_if(odd), 2U);
+  EXPECT_EQ(queue.size(), 4U);
+}
+
+TEST(QueueTest, BlockWaitsForRoom) {
+  safe::queue_t<int> queue {2, safe::overflow_e::block};
+
+  std::jthread producer([&]() {
+    for (int x = 0; x < 1000; ++x) {
+      queue.raise(x);
+    }
+  });
+
+  for (int x = 0; x < 1000; ++x) {
+    ASSERT_EQ(queue.pop(), x);
+  }
+  producer.join();
+
+  auto stats = queue.stats();
+  EXPECT_LE(stats.high_water, 2U);
+  EXPECT_EQ(stats.dropped, 0U);
+}
+
+TEST(QueueTest, StopWakesBlockedProducer) {
+  safe::queue_t<int> queue {1, safe::overflow_e::block};
+  queue.raise(0);
+
+  std::jthread producer([&]() {
+    queue.raise(1);
+  });
+
+  // Wait for the producer to find the queue full
+  while (queue.stats().overflows == 0) {
+    std::this_thread::yield();
+  }
+
+  queue.stop();
+  producer.join();
+
+  EXPECT_EQ(queue.size(), 1U);
+}
+
+namespace {
+  constexpr safe::event_id_t<int> test_event {{0, "test_event"}};
+  constexpr safe::queue_id_t<int> test_queue {{1, "test_queue"}};
+}  // namespace
+
+TEST(MailTest, DeclaredChannelsAreShared) {
+  auto mail = std::make_shared<safe::mail_raw_t>();
+
+  auto event = mail->event(test_event);
+  mail->event<int>(test_event)->raise(42);
+  EXPECT_EQ(event->pop(), 42);
+
+  auto queue = mail->queue(test_queue);
+  EXPECT_EQ(mail->queue<int>(test_queue), queue);
+
+  // Mailboxes don't share channels
+  EXPECT_NE(std::make_shared<safe::mail_raw_t>()->event(test_event), event);
+}
+
+TEST(MailTest, ChannelIsRecreatedOnceNobodyHoldsIt) {
+  auto mail = std::make_shared<safe::mail_raw_t>();
+
+  auto queue = mail->queue(test_queue);
+  queue->stop();
+  queue.reset();
+
+  EXPECT_TRUE(mail->queue(test_queue)->running());
+}
+
+TEST(MailTest, NamedChannelsStillWork) {
+  auto mail = std::make_shared<safe::mail_raw_t>();
+
+  auto event = mail->event<int>("named"sv);
+  mail->event<int>("named"sv)->raise(7);
+  EXPECT_EQ(event->pop(), 7);
+
+  event.reset();
+  EXPECT_TRUE(mail->id_to_post.empty());
+}